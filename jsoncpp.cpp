@@ -94,6 +94,9 @@ license you like.
  * It is an internal header that must not be exposed.
  */
 
+#include <cfloat>
+#include <climits>
+
 namespace Json {
 
 /// Converts a unicode code-point to UTF-8.
@@ -143,11 +146,31 @@ typedef char UIntToStringBuffer[uintToStringBufferSize];
  *        Must have at least uintToStringBufferSize chars free.
  */
 static inline void uintToString(LargestUInt value, char*& current) {
+  // Two digits per division.
+  static const char digitPairs[] = "00010203040506070809"
+                                   "10111213141516171819"
+                                   "20212223242526272829"
+                                   "30313233343536373839"
+                                   "40414243444546474849"
+                                   "50515253545556575859"
+                                   "60616263646566676869"
+                                   "70717273747576777879"
+                                   "80818283848586878889"
+                                   "90919293949596979899";
   *--current = 0;
-  do {
-    *--current = char(value % 10) + '0';
-    value /= 10;
-  } while (value != 0);
+  while (value >= 100) {
+    const char* pair = digitPairs + 2 * (value % 100);
+    value /= 100;
+    *--current = pair[1];
+    *--current = pair[0];
+  }
+  if (value >= 10) {
+    const char* pair = digitPairs + 2 * value;
+    *--current = pair[1];
+    *--current = pair[0];
+  } else {
+    *--current = char(value) + '0';
+  }
 }
 
 /** Change ',' to '.' everywhere in buffer.
@@ -164,6 +187,105 @@ static inline void fixNumericLocale(char* begin, char* end) {
   }
 }
 
+/** Converts a JSON number token to the nearest double, without locale.
+ *
+ * Handles the common case exactly (Clinger's fast path): at most 19
+ * significant digits whose value fits in the 53-bit mantissa, scaled by a
+ * power of ten that is itself exactly representable. Both operands are then
+ * exact and IEEE arithmetic rounds the single product or quotient correctly.
+ * @return false if the token is malformed or outside the fast path; the
+ *         caller must then use a slower, fully general conversion.
+ */
+static inline bool decimalToDouble(const char* begin, const char* end,
+                                   double& value) {
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD != 0
+  // Extended precision intermediates (x87) would round twice.
+  return false;
+#endif
+  static const double powersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  const int maxExactPower = 22;
+  const unsigned long long maxExactMantissa = 1ULL << 53;
+
+  const char* current = begin;
+  bool isNegative = current != end && *current == '-';
+  if (isNegative)
+    ++current;
+  if (current == end || *current < '0' || *current > '9')
+    return false;
+
+  // Digits are counted from the first nonzero one, including zeros after it,
+  // and the overflow check comes before the multiplication: a mantissa that
+  // wrapped to 0 (e.g. 2^64) would otherwise pass for a zero.
+  const unsigned long long maxMantissa = (ULLONG_MAX - 9) / 10;
+  unsigned long long mantissa = 0;
+  int significantDigits = 0;
+  int exponent = 0;
+  for (; current != end && *current >= '0' && *current <= '9'; ++current) {
+    if (mantissa > maxMantissa)
+      return false;
+    mantissa = mantissa * 10 + (*current - '0');
+    if ((mantissa != 0 || significantDigits != 0) && ++significantDigits > 19)
+      return false;
+  }
+  if (current != end && *current == '.') {
+    if (++current == end || *current < '0' || *current > '9')
+      return false;
+    for (; current != end && *current >= '0' && *current <= '9'; ++current) {
+      if (mantissa > maxMantissa)
+        return false;
+      mantissa = mantissa * 10 + (*current - '0');
+      if ((mantissa != 0 || significantDigits != 0) && ++significantDigits > 19)
+        return false;
+      --exponent;
+    }
+  }
+  if (current != end && (*current == 'e' || *current == 'E')) {
+    ++current;
+    bool isNegativeExponent = current != end && *current == '-';
+    if (current != end && (*current == '-' || *current == '+'))
+      ++current;
+    if (current == end || *current < '0' || *current > '9')
+      return false;
+    int explicitExponent = 0;
+    for (; current != end && *current >= '0' && *current <= '9'; ++current) {
+      if (explicitExponent < 10000)
+        explicitExponent = explicitExponent * 10 + (*current - '0');
+    }
+    exponent += isNegativeExponent ? -explicitExponent : explicitExponent;
+  }
+  if (current != end)
+    return false;
+
+  if (mantissa == 0) {
+    value = isNegative ? -0.0 : 0.0;
+    return true;
+  }
+  if (mantissa > maxExactMantissa)
+    return false;
+  if (exponent > maxExactPower) {
+    // 1.5e25 is 15e24: move the excess power into the mantissa while it
+    // stays exact, e.g. 15000 * 1e22.
+    for (; exponent > maxExactPower; --exponent) {
+      if (mantissa > maxExactMantissa / 10)
+        return false;
+      mantissa *= 10;
+    }
+  }
+  if (exponent < -maxExactPower)
+    return false;
+
+  double result = double(mantissa);
+  if (exponent < 0)
+    result /= powersOfTen[-exponent];
+  else
+    result *= powersOfTen[exponent];
+  value = isNegative ? -result : result;
+  return true;
+}
+
 } // namespace Json {
 
 #endif // LIB_JSONCPP_JSON_TOOL_H_INCLUDED
@@ -195,8 +317,16 @@ static inline void fixNumericLocale(char* begin, char* end) {
 #include <utility>
 #include <cstdio>
 #include <cassert>
+#include <algorithm>
+#include <clocale>
+#include <cstdlib>
 #include <cstring>
 #include <istream>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 #if defined(_MSC_VER) && _MSC_VER < 1500 // VC++ 8.0 and below
 #define snprintf _snprintf
@@ -214,7 +344,9 @@ namespace Json {
 
 Features::Features()
     : allowComments_(true), strictRoot_(false),
-      allowDroppedNullPlaceholders_(false), allowNumericKeys_(false) {}
+      allowDroppedNullPlaceholders_(false), allowNumericKeys_(false),
+      validateUTF8_(false), trackOffsets_(true), recoverFromErrors_(true),
+      maxDepth_(1000) {}
 
 Features Features::all() { return Features(); }
 
@@ -224,6 +356,15 @@ Features Features::strictMode() {
   features.strictRoot_ = true;
   features.allowDroppedNullPlaceholders_ = false;
   features.allowNumericKeys_ = false;
+  features.validateUTF8_ = true;
+  return features;
+}
+
+Features Features::fast() {
+  Features features;
+  features.allowComments_ = false;
+  features.trackOffsets_ = false;
+  features.recoverFromErrors_ = false;
   return features;
 }
 
@@ -254,18 +395,257 @@ static bool containsNewLine(Reader::Location begin, Reader::Location end) {
   return false;
 }
 
+// Byte scanning
+// //////////////////////////////////////////////////////////////////
+//
+// Most of the reader's time goes into finding the end of a whitespace run or
+// of a string. On x86 these helpers test 16 bytes at a time with SSE2, which
+// every x86-64 CPU has, and move to 32 bytes at a time with AVX2 once a run
+// proves long, provided the CPU supports it (checked once at run time).
+// Short runs never leave the inline first check. Other targets use the
+// scalar loops.
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSON_READER_SSE2 1
+#if defined(_MSC_VER)
+#define JSON_READER_AVX2 1
+#define JSON_AVX2_TARGET
+#elif defined(__clang__) ||                                                    \
+    (defined(__GNUC__) &&                                                      \
+     (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define JSON_READER_AVX2 1
+#define JSON_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+static inline bool isSpace(Reader::Char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/// Returns true if c ends an undecoded run of string content: the closing
+/// quote, an escape, or (when validating) the lead byte of a UTF-8 sequence.
+static inline bool isStringDelimiter(Reader::Char c, bool stopAtNonASCII) {
+  return c == '"' || c == '\\' || (stopAtNonASCII && (c & 0x80) != 0);
+}
+
+static Reader::Location skipSpacesScalar(Reader::Location current,
+                                         Reader::Location end) {
+  while (current != end && isSpace(*current))
+    ++current;
+  return current;
+}
+
+static Reader::Location findStringDelimiterScalar(Reader::Location current,
+                                                  Reader::Location end,
+                                                  bool stopAtNonASCII) {
+  while (current != end && !isStringDelimiter(*current, stopAtNonASCII))
+    ++current;
+  return current;
+}
+
+#if defined(JSON_READER_SSE2)
+
+static inline int countTrailingZeros(unsigned int mask) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return int(index);
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+/// Bit i is set if p[i] is not whitespace.
+static inline unsigned int nonSpaceMask16(Reader::Location p) {
+  __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  __m128i spaces =
+      _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+                   _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')),
+                                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))));
+  return ~unsigned(_mm_movemask_epi8(spaces)) & 0xFFFF;
+}
+
+/// Bit i is set if p[i] is a string delimiter (see isStringDelimiter).
+static inline unsigned int stringDelimiterMask16(Reader::Location p,
+                                                 bool stopAtNonASCII) {
+  __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  unsigned int mask = unsigned(_mm_movemask_epi8(
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')),
+                   _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')))));
+  if (stopAtNonASCII)
+    mask |= unsigned(_mm_movemask_epi8(chunk));
+  return mask;
+}
+
+#if defined(JSON_READER_AVX2)
+
+static bool cpuHasAVX2() {
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+  // The OS must also save the YMM registers (OSXSAVE and XCR0 bits 1-2).
+  __cpuid(info, 1);
+  if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 ||
+      (_xgetbv(0) & 6) != 6)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+static bool useAVX2() {
+  static const bool supported = cpuHasAVX2();
+  return supported;
+}
+
+JSON_AVX2_TARGET static Reader::Location
+skipSpacesAVX2(Reader::Location current, Reader::Location end) {
+  const __m256i space = _mm256_set1_epi8(' '), tab = _mm256_set1_epi8('\t'),
+                cr = _mm256_set1_epi8('\r'), lf = _mm256_set1_epi8('\n');
+  for (; end - current >= 32; current += 32) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current));
+    __m256i spaces = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space),
+                        _mm256_cmpeq_epi8(chunk, tab)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, cr),
+                        _mm256_cmpeq_epi8(chunk, lf)));
+    unsigned int mask = ~unsigned(_mm256_movemask_epi8(spaces));
+    if (mask)
+      return current + countTrailingZeros(mask);
+  }
+  return skipSpacesScalar(current, end);
+}
+
+JSON_AVX2_TARGET static Reader::Location
+findStringDelimiterAVX2(Reader::Location current,
+                        Reader::Location end,
+                        bool stopAtNonASCII) {
+  const __m256i quote = _mm256_set1_epi8('"'),
+                backslash = _mm256_set1_epi8('\\');
+  for (; end - current >= 32; current += 32) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current));
+    unsigned int mask = unsigned(_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote),
+                        _mm256_cmpeq_epi8(chunk, backslash))));
+    if (stopAtNonASCII)
+      mask |= unsigned(_mm256_movemask_epi8(chunk));
+    if (mask)
+      return current + countTrailingZeros(mask);
+  }
+  return findStringDelimiterScalar(current, end, stopAtNonASCII);
+}
+
+#endif // if defined(JSON_READER_AVX2)
+#endif // if defined(JSON_READER_SSE2)
+
+/// Returns the first non-whitespace position in [current, end).
+static inline Reader::Location skipWhitespace(Reader::Location current,
+                                              Reader::Location end) {
+  if (current == end || !isSpace(*current))
+    return current;
+#if defined(JSON_READER_SSE2)
+  if (end - current >= 16) {
+    unsigned int mask = nonSpaceMask16(current);
+    if (mask)
+      return current + countTrailingZeros(mask);
+    current += 16;
+#if defined(JSON_READER_AVX2)
+    if (useAVX2())
+      return skipSpacesAVX2(current, end);
+#endif
+    for (; end - current >= 16; current += 16) {
+      mask = nonSpaceMask16(current);
+      if (mask)
+        return current + countTrailingZeros(mask);
+    }
+  }
+#endif
+  return skipSpacesScalar(current, end);
+}
+
+/// Returns the first string delimiter (see isStringDelimiter) in
+/// [current, end), or end.
+static inline Reader::Location findStringDelimiter(Reader::Location current,
+                                                   Reader::Location end,
+                                                   bool stopAtNonASCII) {
+#if defined(JSON_READER_SSE2)
+  if (end - current >= 16) {
+    unsigned int mask = stringDelimiterMask16(current, stopAtNonASCII);
+    if (mask)
+      return current + countTrailingZeros(mask);
+    current += 16;
+#if defined(JSON_READER_AVX2)
+    if (useAVX2())
+      return findStringDelimiterAVX2(current, end, stopAtNonASCII);
+#endif
+    for (; end - current >= 16; current += 16) {
+      mask = stringDelimiterMask16(current, stopAtNonASCII);
+      if (mask)
+        return current + countTrailingZeros(mask);
+    }
+  }
+#endif
+  return findStringDelimiterScalar(current, end, stopAtNonASCII);
+}
+
+/// Returns the end of the UTF-8 sequence whose lead byte is at current, or 0
+/// if the sequence is truncated, overlong, a surrogate or above U+10FFFF.
+static Reader::Location validUTF8Sequence(Reader::Location current,
+                                          Reader::Location end) {
+  unsigned char lead = static_cast<unsigned char>(*current);
+  unsigned char low = 0x80, high = 0xBF;
+  int length;
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    length = 2;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    length = 3;
+    if (lead == 0xE0)
+      low = 0xA0;
+    else if (lead == 0xED)
+      high = 0x9F;
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    length = 4;
+    if (lead == 0xF0)
+      low = 0x90;
+    else if (lead == 0xF4)
+      high = 0x8F;
+  } else {
+    return 0;
+  }
+  if (end - current < length)
+    return 0;
+  unsigned char second = static_cast<unsigned char>(current[1]);
+  if (second < low || second > high)
+    return 0;
+  for (int index = 2; index < length; ++index)
+    if ((current[index] & 0xC0) != 0x80)
+      return 0;
+  return current + length;
+}
+
 // Class Reader
 // //////////////////////////////////////////////////////////////////
 
 Reader::Reader()
-    : errors_(), document_(), begin_(), end_(), current_(), lastValueEnd_(),
-      lastValue_(), commentsBefore_(), features_(Features::all()),
+    : frames_(), depth_(), node_(), errors_(),
+      document_(), begin_(), end_(), current_(), lastValueEnd_(), lastValue_(),
+      commentsBefore_(), stringBuffer_(), arena_(), features_(Features::all()),
       collectComments_() {}
 
 Reader::Reader(const Features& features)
-    : errors_(), document_(), begin_(), end_(), current_(), lastValueEnd_(),
-      lastValue_(), commentsBefore_(), features_(features), collectComments_() {
-}
+    : frames_(), depth_(), node_(), errors_(), document_(),
+      begin_(), end_(), current_(), lastValueEnd_(), lastValue_(),
+      commentsBefore_(), stringBuffer_(), arena_(), features_(features),
+      collectComments_() {}
 
 bool
 Reader::parse(const std::string& document, Value& root, bool collectComments) {
@@ -288,6 +668,24 @@ bool Reader::parse(std::istream& sin, Value& root, bool collectComments) {
   return parse(doc, root, collectComments);
 }
 
+bool Reader::parse(const std::string& document, Value& root, Arena& arena) {
+  document_ = document;
+  const char* begin = document_.c_str();
+  const char* end = begin + document_.length();
+  return parse(begin, end, root, arena);
+}
+
+bool Reader::parse(const char* beginDoc,
+                   const char* endDoc,
+                   Value& root,
+                   Arena& arena) {
+  // Comments are kept outside the arena and would leak on release().
+  arena_ = &arena;
+  bool successful = parse(beginDoc, endDoc, root, false);
+  arena_ = 0;
+  return successful;
+}
+
 bool Reader::parse(const char* beginDoc,
                    const char* endDoc,
                    Value& root,
@@ -304,9 +702,8 @@ bool Reader::parse(const char* beginDoc,
   lastValue_ = 0;
   commentsBefore_ = "";
   errors_.clear();
-  while (!nodes_.empty())
-    nodes_.pop();
-  nodes_.push(&root);
+  depth_ = 0;
+  node_ = &root;
 
   bool successful = readValue();
   Token token;
@@ -330,6 +727,32 @@ bool Reader::parse(const char* beginDoc,
 }
 
 bool Reader::readValue() {
+  // Objects and arrays are read without recursion: beginValue() pushes a
+  // frame for each one it opens, and the loop reads members of the innermost
+  // frame until it closes. Native stack use does not depend on the document.
+  const size_t outerDepth = depth_;
+  bool successful = beginValue();
+  while (depth_ > outerDepth) {
+    Frame& frame = frames_[depth_ - 1];
+    bool memberPending = frame.isObject_ ? readObjectMember(frame, successful)
+                                         : readArrayElement(frame, successful);
+    if (memberPending) {
+      successful = beginValue();
+      continue;
+    }
+    // The container is closed, or was skipped after an error.
+    node_ = frame.value_;
+    --depth_;
+    setCurrentOffsets(frame.start_, current_);
+    if (collectComments_) {
+      lastValueEnd_ = current_;
+      lastValue_ = node_;
+    }
+  }
+  return successful;
+}
+
+bool Reader::beginValue() {
   Token token;
   skipCommentTokens(token);
   bool successful = true;
@@ -349,13 +772,26 @@ bool Reader::readValue() {
 
   switch (token.type_) {
   case tokenObjectBegin:
-    successful = readObject(token);
-    currentValue().setOffsetLimit(current_ - begin_);
-    break;
-  case tokenArrayBegin:
-    successful = readArray(token);
-    currentValue().setOffsetLimit(current_ - begin_);
-    break;
+  case tokenArrayBegin: {
+    if (depth_ == features_.maxDepth_) {
+      setCurrentOffsets(token.start_, token.end_);
+      return addError("Objects and arrays are nested too deeply.", token);
+    }
+    // Frames are kept between parses, so only a deeper document allocates.
+    if (depth_ == frames_.size())
+      frames_.push_back(Frame());
+    bool isObject = token.type_ == tokenObjectBegin;
+    ValueType type = isObject ? objectValue : arrayValue;
+    currentValue() = arena_ ? Value(type, *arena_) : Value(type);
+    Frame& frame = frames_[depth_++];
+    frame.value_ = node_;
+    frame.start_ = token.start_;
+    frame.index_ = 0;
+    frame.isObject_ = isObject;
+    frame.hasMember_ = false;
+    frame.lastNameEmpty_ = true;
+    return true;
+  }
   case tokenNumber:
     successful = decodeNumber(token);
     break;
@@ -364,18 +800,15 @@ bool Reader::readValue() {
     break;
   case tokenTrue:
     currentValue() = true;
-    currentValue().setOffsetStart(token.start_ - begin_);
-    currentValue().setOffsetLimit(token.end_ - begin_);
+    setCurrentOffsets(token.start_, token.end_);
     break;
   case tokenFalse:
     currentValue() = false;
-    currentValue().setOffsetStart(token.start_ - begin_);
-    currentValue().setOffsetLimit(token.end_ - begin_);
+    setCurrentOffsets(token.start_, token.end_);
     break;
   case tokenNull:
     currentValue() = Value();
-    currentValue().setOffsetStart(token.start_ - begin_);
-    currentValue().setOffsetLimit(token.end_ - begin_);
+    setCurrentOffsets(token.start_, token.end_);
     break;
   case tokenArraySeparator:
     if (features_.allowDroppedNullPlaceholders_) {
@@ -383,14 +816,12 @@ bool Reader::readValue() {
       // token.
       current_--;
       currentValue() = Value();
-      currentValue().setOffsetStart(current_ - begin_ - 1);
-      currentValue().setOffsetLimit(current_ - begin_);
+      setCurrentOffsets(current_ - 1, current_);
       break;
     }
   // Else, fall through...
   default:
-    currentValue().setOffsetStart(token.start_ - begin_);
-    currentValue().setOffsetLimit(token.end_ - begin_);
+    setCurrentOffsets(token.start_, token.end_);
     return addError("Syntax error: value, object or array expected.", token);
   }
 
@@ -412,6 +843,13 @@ void Reader::skipCommentTokens(Token& token) {
   }
 }
 
+void Reader::setCurrentOffsets(Location start, Location limit) {
+  if (features_.trackOffsets_) {
+    currentValue().setOffsetStart(start - begin_);
+    currentValue().setOffsetLimit(limit - begin_);
+  }
+}
+
 bool Reader::expectToken(TokenType type, Token& token, const char* message) {
   readToken(token);
   if (token.type_ != type)
@@ -490,15 +928,7 @@ bool Reader::readToken(Token& token) {
   return true;
 }
 
-void Reader::skipSpaces() {
-  while (current_ != end_) {
-    Char c = *current_;
-    if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
-      ++current_;
-    else
-      break;
-  }
-}
+void Reader::skipSpaces() { current_ = skipWhitespace(current_, end_); }
 
 bool Reader::match(Location pattern, int patternLength) {
   if (end_ - current_ < patternLength)
@@ -573,116 +1003,137 @@ void Reader::readNumber() {
 }
 
 bool Reader::readString() {
-  Char c = 0;
-  while (current_ != end_) {
-    c = getNextChar();
-    if (c == '\\')
-      getNextChar();
-    else if (c == '"')
-      break;
+  for (;;) {
+    current_ = findStringDelimiter(current_, end_, false);
+    if (current_ == end_)
+      return false;
+    if (*current_++ == '"')
+      return true;
+    if (current_ == end_)
+      return false;
+    ++current_; // escaped character
   }
-  return c == '"';
 }
 
-bool Reader::readObject(Token& tokenStart) {
-  Token tokenName;
-  std::string name;
-  currentValue() = Value(objectValue);
-  currentValue().setOffsetStart(tokenStart.start_ - begin_);
-  while (readToken(tokenName)) {
-    bool initialTokenOk = true;
-    while (tokenName.type_ == tokenComment && initialTokenOk)
-      initialTokenOk = readToken(tokenName);
-    if (!initialTokenOk)
-      break;
-    if (tokenName.type_ == tokenObjectEnd && name.empty()) // empty object
-      return true;
-    name = "";
-    if (tokenName.type_ == tokenString) {
-      if (!decodeString(tokenName, name))
-        return recoverFromError(tokenObjectEnd);
-    } else if (tokenName.type_ == tokenNumber && features_.allowNumericKeys_) {
-      Value numberName;
-      if (!decodeNumber(tokenName, numberName))
-        return recoverFromError(tokenObjectEnd);
-      name = numberName.asString();
-    } else {
-      break;
-    }
-
-    Token colon;
-    if (!readToken(colon) || colon.type_ != tokenMemberSeparator) {
-      return addErrorAndRecover(
-          "Missing ':' after object member name", colon, tokenObjectEnd);
+// Reads up to the next member name of frame, whose object is the current
+// value. Returns true with node_ set to that member if its value must be read
+// next; returns false once the object is closed or abandoned, with successful
+// telling which. successful holds the result of the previous member on entry.
+bool Reader::readObjectMember(Frame& frame, bool& successful) {
+  if (frame.hasMember_) {
+    if (!successful) { // error already set
+      successful = recoverFromError(tokenObjectEnd);
+      return false;
     }
-    Value& value = currentValue()[name];
-    nodes_.push(&value);
-    bool ok = readValue();
-    nodes_.pop();
-    if (!ok) // error already set
-      return recoverFromError(tokenObjectEnd);
 
     Token comma;
     if (!readToken(comma) ||
         (comma.type_ != tokenObjectEnd && comma.type_ != tokenArraySeparator &&
          comma.type_ != tokenComment)) {
-      return addErrorAndRecover(
+      successful = addErrorAndRecover(
           "Missing ',' or '}' in object declaration", comma, tokenObjectEnd);
+      return false;
     }
     bool finalizeTokenOk = true;
     while (comma.type_ == tokenComment && finalizeTokenOk)
       finalizeTokenOk = readToken(comma);
-    if (comma.type_ == tokenObjectEnd)
-      return true;
+    if (comma.type_ == tokenObjectEnd) {
+      successful = true;
+      return false;
+    }
   }
-  return addErrorAndRecover(
-      "Missing '}' or object member name", tokenName, tokenObjectEnd);
-}
 
-bool Reader::readArray(Token& tokenStart) {
-  currentValue() = Value(arrayValue);
-  currentValue().setOffsetStart(tokenStart.start_ - begin_);
-  skipSpaces();
-  if (*current_ == ']') // empty array
-  {
-    Token endArray;
-    readToken(endArray);
-    return true;
+  Token tokenName;
+  bool initialTokenOk = readToken(tokenName);
+  while (tokenName.type_ == tokenComment && initialTokenOk)
+    initialTokenOk = readToken(tokenName);
+  if (initialTokenOk && tokenName.type_ == tokenObjectEnd &&
+      frame.lastNameEmpty_) { // empty object
+    successful = true;
+    return false;
   }
-  int index = 0;
-  for (;;) {
-    Value& value = currentValue()[index++];
-    nodes_.push(&value);
-    bool ok = readValue();
-    nodes_.pop();
-    if (!ok) // error already set
-      return recoverFromError(tokenArrayEnd);
+  std::string& name = stringBuffer_;
+  name.clear();
+  if (initialTokenOk && tokenName.type_ == tokenString) {
+    if (!decodeString(tokenName, name)) {
+      successful = recoverFromError(tokenObjectEnd);
+      return false;
+    }
+  } else if (initialTokenOk && tokenName.type_ == tokenNumber &&
+             features_.allowNumericKeys_) {
+    Value numberName;
+    if (!decodeNumber(tokenName, numberName)) {
+      successful = recoverFromError(tokenObjectEnd);
+      return false;
+    }
+    name = numberName.asString();
+  } else {
+    successful = addErrorAndRecover(
+        "Missing '}' or object member name", tokenName, tokenObjectEnd);
+    return false;
+  }
+
+  Token colon;
+  if (!readToken(colon) || colon.type_ != tokenMemberSeparator) {
+    successful = addErrorAndRecover(
+        "Missing ':' after object member name", colon, tokenObjectEnd);
+    return false;
+  }
+  node_ = &(*frame.value_)[name];
+  frame.hasMember_ = true;
+  frame.lastNameEmpty_ = name.empty();
+  return true;
+}
+
+// Same as readObjectMember() for the elements of an array.
+bool Reader::readArrayElement(Frame& frame, bool& successful) {
+  if (!frame.hasMember_) {
+    skipSpaces();
+    if (current_ != end_ && *current_ == ']') // empty array
+    {
+      Token endArray;
+      readToken(endArray);
+      successful = true;
+      return false;
+    }
+  } else {
+    if (!successful) { // error already set
+      successful = recoverFromError(tokenArrayEnd);
+      return false;
+    }
 
     Token token;
     // Accept Comment after last item in the array.
-    ok = readToken(token);
+    bool ok = readToken(token);
     while (token.type_ == tokenComment && ok) {
       ok = readToken(token);
     }
     bool badTokenType =
         (token.type_ != tokenArraySeparator && token.type_ != tokenArrayEnd);
     if (!ok || badTokenType) {
-      return addErrorAndRecover(
+      successful = addErrorAndRecover(
           "Missing ',' or ']' in array declaration", token, tokenArrayEnd);
+      return false;
+    }
+    if (token.type_ == tokenArrayEnd) {
+      successful = true;
+      return false;
     }
-    if (token.type_ == tokenArrayEnd)
-      break;
   }
+  node_ = &(*frame.value_)[frame.index_++];
+  // Appending may move the elements: lastValue_, the previous element, is
+  // still the target of a comment that follows it on the same line.
+  if (collectComments_ && frame.index_ > 1)
+    lastValue_ = &(*frame.value_)[frame.index_ - 2];
+  frame.hasMember_ = true;
   return true;
 }
 
 bool Reader::decodeNumber(Token& token) {
-  Value decoded;
-  if (!decodeNumber(token, decoded))
+  // Only assigned on success, so no temporary is needed.
+  if (!decodeNumber(token, currentValue()))
     return false;
-  currentValue() = decoded;
-  currentValue().setOffsetStart(token.start_ - begin_);
-  currentValue().setOffsetLimit(token.end_ - begin_);
+  setCurrentOffsets(token.start_, token.end_);
   return true;
 }
 
@@ -735,44 +1186,33 @@ bool Reader::decodeNumber(Token& token, Value& decoded) {
 }
 
 bool Reader::decodeDouble(Token& token) {
-  Value decoded;
-  if (!decodeDouble(token, decoded))
+  // Only assigned on success, so no temporary is needed.
+  if (!decodeDouble(token, currentValue()))
     return false;
-  currentValue() = decoded;
-  currentValue().setOffsetStart(token.start_ - begin_);
-  currentValue().setOffsetLimit(token.end_ - begin_);
+  setCurrentOffsets(token.start_, token.end_);
   return true;
 }
 
 bool Reader::decodeDouble(Token& token, Value& decoded) {
   double value = 0;
-  const int bufferSize = 32;
-  int count;
-  int length = int(token.end_ - token.start_);
-
-  // Sanity check to avoid buffer overflow exploits.
-  if (length < 0) {
-    return addError("Unable to parse token length", token);
-  }
-
-  // Avoid using a string constant for the format control string given to
-  // sscanf, as this can cause hard to debug crashes on OS X. See here for more
-  // info:
-  //
-  //     http://developer.apple.com/library/mac/#DOCUMENTATION/DeveloperTools/gcc-4.0.1/gcc/Incompatibilities.html
-  char format[] = "%lf";
-
-  if (length <= bufferSize) {
-    Char buffer[bufferSize + 1];
-    memcpy(buffer, token.start_, length);
-    buffer[length] = 0;
-    count = sscanf(buffer, format, &value);
-  } else {
-    std::string buffer(token.start_, token.end_);
-    count = sscanf(buffer.c_str(), format, &value);
+  if (decimalToDouble(token.start_, token.end_, value)) {
+    decoded = value;
+    return true;
   }
 
-  if (count != 1)
+  // Tokens the fast path can not convert exactly (long mantissas, extreme
+  // exponents) or that are not well-formed JSON numbers go through strtod.
+  // strtod reads the decimal point of the current locale, so substitute it
+  // for '.' (the reverse of fixNumericLocale). Like the sscanf this
+  // replaces, a valid prefix of the token is accepted and out of range
+  // values become +-HUGE_VAL, which is how the writer spells infinity.
+  std::string buffer(token.start_, token.end_);
+  const char* decimalPoint = localeconv()->decimal_point;
+  if (decimalPoint[0] != '.' && decimalPoint[0] != 0 && decimalPoint[1] == 0)
+    std::replace(buffer.begin(), buffer.end(), '.', decimalPoint[0]);
+  char* parsedEnd = 0;
+  value = strtod(buffer.c_str(), &parsedEnd);
+  if (parsedEnd == buffer.c_str())
     return addError("'" + std::string(token.start_, token.end_) +
                         "' is not a number.",
                     token);
@@ -781,12 +1221,16 @@ bool Reader::decodeDouble(Token& token, Value& decoded) {
 }
 
 bool Reader::decodeString(Token& token) {
-  std::string decoded;
+  std::string& decoded = stringBuffer_;
+  decoded.clear();
   if (!decodeString(token, decoded))
     return false;
-  currentValue() = decoded;
-  currentValue().setOffsetStart(token.start_ - begin_);
-  currentValue().setOffsetLimit(token.end_ - begin_);
+  if (arena_)
+    currentValue() =
+        Value(decoded.data(), decoded.data() + decoded.size(), *arena_);
+  else
+    currentValue() = decoded;
+  setCurrentOffsets(token.start_, token.end_);
   return true;
 }
 
@@ -794,7 +1238,13 @@ bool Reader::decodeString(Token& token, std::string& decoded) {
   decoded.reserve(token.end_ - token.start_ - 2);
   Location current = token.start_ + 1; // skip '"'
   Location end = token.end_ - 1;       // do not include '"'
+  bool validateUTF8 = features_.validateUTF8_;
   while (current != end) {
+    Location run = findStringDelimiter(current, end, validateUTF8);
+    decoded.append(current, run);
+    current = run;
+    if (current == end)
+      break;
     Char c = *current++;
     if (c == '"')
       break;
@@ -837,7 +1287,12 @@ bool Reader::decodeString(Token& token, std::string& decoded) {
         return addError("Bad escape sequence in string", token, current);
       }
     } else {
-      decoded += c;
+      // Only reached when validating: the lead byte of a UTF-8 sequence.
+      Location sequenceEnd = validUTF8Sequence(current - 1, end);
+      if (!sequenceEnd)
+        return addError("Invalid UTF-8 sequence in string", token, current - 1);
+      decoded.append(current - 1, sequenceEnd);
+      current = sequenceEnd;
     }
   }
   return true;
@@ -911,6 +1366,8 @@ Reader::addError(const std::string& message, Token& token, Location extra) {
 }
 
 bool Reader::recoverFromError(TokenType skipUntilToken) {
+  if (!features_.recoverFromErrors_)
+    return false;
   int errorCount = int(errors_.size());
   Token skip;
   for (;;) {
@@ -930,7 +1387,7 @@ bool Reader::addErrorAndRecover(const std::string& message,
   return recoverFromError(skipUntilToken);
 }
 
-Value& Reader::currentValue() { return *(nodes_.top()); }
+Value& Reader::currentValue() { return *node_; }
 
 Reader::Char Reader::getNextChar() {
   if (current_ == end_)
@@ -1013,6 +1470,452 @@ std::vector<Reader::StructuredError> Reader::getStructuredErrors() const {
   return allErrors;
 }
 
+bool Reader::parse(const std::string& text, LazyDocument& document) {
+  return parse(text.data(), text.data() + text.size(), document);
+}
+
+bool Reader::parse(const char* beginDoc,
+                   const char* endDoc,
+                   LazyDocument& document) {
+  begin_ = beginDoc;
+  end_ = endDoc;
+  collectComments_ = false;
+  current_ = begin_;
+  lastValueEnd_ = 0;
+  lastValue_ = 0;
+  commentsBefore_.clear();
+  errors_.clear();
+  document.nodes_.clear();
+  document.children_.clear();
+  document.pending_.clear();
+  document.open_.clear();
+  document.decoder_.features_ = features_;
+
+  bool successful = readLazyValue(document);
+  if (successful && features_.strictRoot_ &&
+      document.nodes_[0].type_ != arrayValue &&
+      document.nodes_[0].type_ != objectValue) {
+    Token token;
+    token.type_ = tokenError;
+    token.start_ = beginDoc;
+    token.end_ = endDoc;
+    addError(
+        "A valid JSON document must be either an array or an object value.",
+        token);
+    successful = false;
+  }
+  if (!successful)
+    document.nodes_.clear();
+  return successful;
+}
+
+// Indexes one value into document, without recursion: open containers are
+// kept in document.open_, and the members read so far in document.pending_.
+bool Reader::readLazyValue(LazyDocument& document) {
+  std::vector<LazyDocument::Node>& nodes = document.nodes_;
+  std::vector<unsigned>& pending = document.pending_;
+  std::vector<LazyDocument::Frame>& open = document.open_;
+  Token token;
+  for (;;) {
+    skipCommentTokens(token);
+    LazyDocument::Node node = {token.start_, token.end_, 0, 0, nullValue};
+    switch (token.type_) {
+    case tokenObjectBegin:
+    case tokenArrayBegin: {
+      if (open.size() == features_.maxDepth_)
+        return addError("Objects and arrays are nested too deeply.", token);
+      node.type_ = token.type_ == tokenObjectBegin ? objectValue : arrayValue;
+      LazyDocument::Frame frame = {unsigned(nodes.size()),
+                                   unsigned(pending.size()), false};
+      open.push_back(frame);
+    } break;
+    case tokenNumber:
+      node.type_ = realValue;
+      break;
+    case tokenString:
+      node.type_ = stringValue;
+      break;
+    case tokenTrue:
+    case tokenFalse:
+      node.type_ = booleanValue;
+      break;
+    case tokenNull:
+      break;
+    default:
+      return addError("Syntax error: value, object or array expected.", token);
+    }
+    nodes.push_back(node);
+
+    // Read separators and close containers up to the start of the next value.
+    for (;;) {
+      if (open.empty())
+        return true;
+      LazyDocument::Frame& frame = open.back();
+      if (nodes[frame.node_].type_ == arrayValue) {
+        if (frame.hasMember_) {
+          skipCommentTokens(token);
+          if (token.type_ == tokenArraySeparator) {
+            pending.push_back(unsigned(nodes.size()));
+            break;
+          }
+          if (token.type_ != tokenArrayEnd)
+            return addError("Missing ',' or ']' in array declaration", token);
+        } else {
+          skipSpaces();
+          if (current_ == end_ || *current_ != ']') {
+            frame.hasMember_ = true;
+            pending.push_back(unsigned(nodes.size()));
+            break;
+          }
+          readToken(token);
+        }
+      } else {
+        skipCommentTokens(token);
+        bool named = false;
+        if (!frame.hasMember_) {
+          named = token.type_ == tokenString;
+        } else if (token.type_ == tokenArraySeparator) {
+          skipCommentTokens(token);
+          if (token.type_ != tokenString)
+            return addError("Missing '}' or object member name", token);
+          named = true;
+        }
+        if (named) {
+          LazyDocument::Node name = {token.start_, token.end_, 0, 0,
+                                     stringValue};
+          pending.push_back(unsigned(nodes.size()));
+          nodes.push_back(name);
+          frame.hasMember_ = true;
+          Token colon;
+          if (!readToken(colon) || colon.type_ != tokenMemberSeparator)
+            return addError("Missing ':' after object member name", colon);
+          break;
+        }
+        if (token.type_ != tokenObjectEnd)
+          return addError(frame.hasMember_
+                              ? "Missing ',' or '}' in object declaration"
+                              : "Missing '}' or object member name",
+                          token);
+      }
+
+      // token closes the innermost container.
+      LazyDocument::Node& container = nodes[frame.node_];
+      container.end_ = token.end_;
+      container.children_ = unsigned(document.children_.size());
+      container.size_ = unsigned(pending.size() - frame.pending_);
+      document.children_.insert(document.children_.end(),
+                                pending.begin() + frame.pending_,
+                                pending.end());
+      pending.resize(frame.pending_);
+      open.pop_back();
+    }
+  }
+}
+
+// Class LazyDocument
+// //////////////////////////////////////////////////////////////////
+
+LazyDocument::LazyDocument() {}
+
+LazyValue LazyDocument::root() const {
+  return nodes_.empty() ? LazyValue() : LazyValue(this, 0);
+}
+
+// Decodes a scalar, or gives an empty container of the same type. A malformed
+// number or string decodes as null.
+bool LazyDocument::decodeScalar(unsigned index, Value& decoded) const {
+  const Node& node = nodes_[index];
+  bool successful = true;
+  switch (node.type_) {
+  case realValue: {
+    Reader::Token token;
+    token.type_ = Reader::tokenNumber;
+    token.start_ = node.start_;
+    token.end_ = node.end_;
+    successful = decoder_.decodeNumber(token, decoded);
+  } break;
+  case stringValue: {
+    std::string& text = decoder_.stringBuffer_;
+    text.clear();
+    successful = decodeString(index, text);
+    if (successful)
+      decoded = text;
+  } break;
+  case booleanValue:
+    decoded = *node.start_ == 't';
+    break;
+  case arrayValue:
+  case objectValue:
+    decoded = Value(node.type_);
+    break;
+  default:
+    decoded = Value();
+    break;
+  }
+  if (!successful) {
+    decoder_.errors_.clear();
+    decoded = Value();
+  }
+  return successful;
+}
+
+// Appends the decoded string node to decoded. A malformed string appends
+// nothing, rather than the part before the error.
+bool LazyDocument::decodeString(unsigned index, std::string& decoded) const {
+  const Node& node = nodes_[index];
+  Reader::Token token;
+  token.type_ = Reader::tokenString;
+  token.start_ = node.start_;
+  token.end_ = node.end_;
+  size_t length = decoded.size();
+  if (decoder_.decodeString(token, decoded))
+    return true;
+  decoder_.errors_.clear();
+  decoded.resize(length);
+  return false;
+}
+
+// Class LazyValue
+// //////////////////////////////////////////////////////////////////
+
+LazyValue::LazyValue() : document_(0), node_(0) {}
+
+LazyValue::LazyValue(const LazyDocument* document, unsigned node)
+    : document_(document), node_(node) {}
+
+ValueType LazyValue::indexedType() const {
+  return document_ ? document_->nodes_[node_].type_ : nullValue;
+}
+
+ValueType LazyValue::type() const {
+  ValueType type = indexedType();
+  return type == realValue ? decodeScalar().type() : type;
+}
+
+bool LazyValue::isNull() const { return indexedType() == nullValue; }
+
+bool LazyValue::isBool() const { return indexedType() == booleanValue; }
+
+bool LazyValue::isNumeric() const { return indexedType() == realValue; }
+
+bool LazyValue::isString() const { return indexedType() == stringValue; }
+
+bool LazyValue::isArray() const { return indexedType() == arrayValue; }
+
+bool LazyValue::isObject() const { return indexedType() == objectValue; }
+
+ArrayIndex LazyValue::size() const {
+  ValueType type = indexedType();
+  if (type != arrayValue && type != objectValue)
+    return 0;
+  ArrayIndex size = document_->nodes_[node_].size_;
+  // Members can repeat a name only if there are several of them.
+  if (type == objectValue && size > 1)
+    size = ArrayIndex(getMemberNames().size());
+  return size;
+}
+
+LazyValue LazyValue::operator[](ArrayIndex index) const {
+  ValueType type = indexedType();
+  JSON_ASSERT_MESSAGE(
+      type == nullValue || type == arrayValue,
+      "in Json::LazyValue::operator[](ArrayIndex)const: requires arrayValue");
+  if (type != arrayValue)
+    return LazyValue();
+  const LazyDocument::Node& node = document_->nodes_[node_];
+  if (index >= node.size_)
+    return LazyValue();
+  return LazyValue(document_, document_->children_[node.children_ + index]);
+}
+
+LazyValue LazyValue::operator[](int index) const {
+  JSON_ASSERT_MESSAGE(
+      index >= 0,
+      "in Json::LazyValue::operator[](int index) const: index cannot be negative");
+  return (*this)[ArrayIndex(index)];
+}
+
+LazyValue LazyValue::operator[](const char* key) const {
+  ValueType type = indexedType();
+  JSON_ASSERT_MESSAGE(
+      type == nullValue || type == objectValue,
+      "in Json::LazyValue::operator[](char const*)const: requires objectValue");
+  if (type != objectValue)
+    return LazyValue();
+  const LazyDocument::Node& node = document_->nodes_[node_];
+  size_t length = strlen(key);
+  std::string decoded;
+  for (unsigned member = node.size_; member-- > 0;) {
+    unsigned name = document_->children_[node.children_ + member];
+    const LazyDocument::Node& nameNode = document_->nodes_[name];
+    const char* begin = nameNode.start_ + 1;
+    size_t rawLength = size_t(nameNode.end_ - 1 - begin);
+    // An escape sequence decodes to fewer characters than it is written
+    // with, so only a longer raw name can need decoding.
+    if (rawLength == length) {
+      if (memcmp(begin, key, length) == 0 && !memchr(begin, '\\', length))
+        return LazyValue(document_, name + 1);
+    } else if (rawLength > length && memchr(begin, '\\', rawLength)) {
+      decoded.clear();
+      if (document_->decodeString(name, decoded) && decoded == key)
+        return LazyValue(document_, name + 1);
+    }
+  }
+  return LazyValue();
+}
+
+LazyValue LazyValue::operator[](const std::string& key) const {
+  return (*this)[key.c_str()];
+}
+
+bool LazyValue::isMember(const char* key) const {
+  return (*this)[key].document_ != 0;
+}
+
+namespace {
+// Orders member positions by the decoded names they refer to.
+struct MemberNameLess {
+  explicit MemberNameLess(const Value::Members& names) : names_(names) {}
+  bool operator()(unsigned a, unsigned b) const {
+    return names_[a] < names_[b];
+  }
+  const Value::Members& names_;
+};
+} // namespace
+
+Value::Members LazyValue::getMemberNames() const {
+  ValueType type = indexedType();
+  JSON_ASSERT_MESSAGE(
+      type == nullValue || type == objectValue,
+      "in Json::LazyValue::getMemberNames(), value must be objectValue");
+  Value::Members members;
+  if (type != objectValue)
+    return members;
+  const LazyDocument::Node& node = document_->nodes_[node_];
+  members.resize(node.size_);
+  for (unsigned member = 0; member < node.size_; ++member)
+    document_->decodeString(document_->children_[node.children_ + member],
+                            members[member]);
+  if (members.size() < 2)
+    return members;
+
+  // A name that appears again later is dropped, as decode() keeps only the
+  // last member of each name. After a stable sort by name, the members that
+  // share a name are adjacent and in document order.
+  std::vector<unsigned> order(members.size());
+  for (unsigned member = 0; member < order.size(); ++member)
+    order[member] = member;
+  std::stable_sort(order.begin(), order.end(), MemberNameLess(members));
+  std::vector<bool> dropped(members.size());
+  for (size_t index = 0; index + 1 < order.size(); ++index)
+    dropped[order[index]] = members[order[index]] == members[order[index + 1]];
+  size_t kept = 0;
+  for (size_t member = 0; member < members.size(); ++member)
+    if (!dropped[member])
+      members[kept++].swap(members[member]);
+  members.resize(kept);
+  return members;
+}
+
+Value::Int LazyValue::asInt() const { return decodeScalar().asInt(); }
+
+Value::UInt LazyValue::asUInt() const { return decodeScalar().asUInt(); }
+
+Value::LargestInt LazyValue::asLargestInt() const {
+  return decodeScalar().asLargestInt();
+}
+
+Value::LargestUInt LazyValue::asLargestUInt() const {
+  return decodeScalar().asLargestUInt();
+}
+
+double LazyValue::asDouble() const { return decodeScalar().asDouble(); }
+
+bool LazyValue::asBool() const { return decodeScalar().asBool(); }
+
+std::string LazyValue::asString() const {
+  if (indexedType() != stringValue)
+    return decodeScalar().asString();
+  std::string decoded;
+  document_->decodeString(node_, decoded);
+  return decoded;
+}
+
+bool LazyValue::getRawString(const char*& begin, const char*& end) const {
+  if (indexedType() != stringValue)
+    return false;
+  const LazyDocument::Node& node = document_->nodes_[node_];
+  const char* rawBegin = node.start_ + 1;
+  const char* rawEnd = node.end_ - 1;
+  if (memchr(rawBegin, '\\', size_t(rawEnd - rawBegin)))
+    return false;
+  begin = rawBegin;
+  end = rawEnd;
+  return true;
+}
+
+Value LazyValue::decodeScalar() const {
+  Value decoded;
+  if (document_)
+    document_->decodeScalar(node_, decoded);
+  return decoded;
+}
+
+Value LazyValue::decode() const {
+  Value root;
+  if (!document_)
+    return root;
+
+  // Containers are filled without recursion, as Reader::readValue() does.
+  // Arrays are sized up front and object members do not move, so the
+  // pointers into the tree stay valid.
+  struct Open {
+    Value* value_;
+    unsigned node_;
+    ArrayIndex next_;
+  };
+  std::vector<Open> open;
+  const std::vector<LazyDocument::Node>& nodes = document_->nodes_;
+  const std::vector<unsigned>& children = document_->children_;
+  std::string name;
+  unsigned node = node_;
+  Value* target = &root;
+  for (;;) {
+    document_->decodeScalar(node, *target);
+    ValueType type = nodes[node].type_;
+    if (type == arrayValue || type == objectValue) {
+      if (type == arrayValue)
+        target->resize(nodes[node].size_);
+      Open container = {target, node, 0};
+      open.push_back(container);
+    }
+
+    // Move to the next value to decode.
+    for (;;) {
+      if (open.empty())
+        return root;
+      Open& top = open.back();
+      const LazyDocument::Node& container = nodes[top.node_];
+      if (top.next_ == container.size_) {
+        open.pop_back();
+        continue;
+      }
+      unsigned child = children[container.children_ + top.next_];
+      if (container.type_ == objectValue) {
+        name.clear();
+        document_->decodeString(child, name);
+        target = &(*top.value_)[name];
+        node = child + 1;
+      } else {
+        target = &(*top.value_)[top.next_];
+        node = child;
+      }
+      ++top.next_;
+      break;
+    }
+  }
+}
+
 std::istream& operator>>(std::istream& sin, Value& root) {
   Json::Reader reader;
   bool ok = reader.parse(sin, root, true);
@@ -1195,7 +2098,7 @@ namespace Json {
 
 ValueIteratorBase::ValueIteratorBase()
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-    : current_(), isNull_(true) {
+    : current_(), isNull_(true), isArray_(false) {
 }
 #else
     : isArray_(true), isNull_(true) {
@@ -1206,7 +2109,13 @@ ValueIteratorBase::ValueIteratorBase()
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
 ValueIteratorBase::ValueIteratorBase(
     const Value::ObjectValues::iterator& current)
-    : current_(current), isNull_(false) {}
+    : current_(current), isNull_(false), isArray_(false) {}
+
+ValueIteratorBase::ValueIteratorBase(
+    const Value::ArrayValues::iterator& begin,
+    const Value::ArrayValues::iterator& current)
+    : current_(), arrayBegin_(begin), arrayCurrent_(current), isNull_(false),
+      isArray_(true) {}
 #else
 ValueIteratorBase::ValueIteratorBase(
     const ValueInternalArray::IteratorState& state)
@@ -1223,6 +2132,8 @@ ValueIteratorBase::ValueIteratorBase(
 
 Value& ValueIteratorBase::deref() const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
+  if (isArray_)
+    return *arrayCurrent_;
   return current_->second;
 #else
   if (isArray_)
@@ -1233,7 +2144,10 @@ Value& ValueIteratorBase::deref() const {
 
 void ValueIteratorBase::increment() {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  ++current_;
+  if (isArray_)
+    ++arrayCurrent_;
+  else
+    ++current_;
 #else
   if (isArray_)
     ValueInternalArray::increment(iterator_.array_);
@@ -1243,7 +2157,10 @@ void ValueIteratorBase::increment() {
 
 void ValueIteratorBase::decrement() {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  --current_;
+  if (isArray_)
+    --arrayCurrent_;
+  else
+    --current_;
 #else
   if (isArray_)
     ValueInternalArray::decrement(iterator_.array_);
@@ -1257,26 +2174,14 @@ ValueIteratorBase::computeDistance(const SelfType& other) const {
 #ifdef JSON_USE_CPPTL_SMALLMAP
   return current_ - other.current_;
 #else
-  // Iterator for null value are initialized using the default
-  // constructor, which initialize current_ to the default
-  // std::map::iterator. As begin() and end() are two instance
-  // of the default std::map::iterator, they can not be compared.
-  // To allow this, we handle this comparison specifically.
+  // Iterators for a null value are default constructed.
   if (isNull_ && other.isNull_) {
     return 0;
   }
+  if (isArray_)
+    return difference_type(arrayCurrent_ - other.arrayCurrent_);
 
-  // Usage of std::distance is not portable (does not compile with Sun Studio 12
-  // RogueWave STL,
-  // which is the one used by default).
-  // Using a portable hand-made version for non random iterator instead:
-  //   return difference_type( std::distance( current_, other.current_ ) );
-  difference_type myDistance = 0;
-  for (Value::ObjectValues::iterator it = current_; it != other.current_;
-       ++it) {
-    ++myDistance;
-  }
-  return myDistance;
+  return difference_type(current_ - other.current_);
 #endif
 #else
   if (isArray_)
@@ -1291,6 +2196,8 @@ bool ValueIteratorBase::isEqual(const SelfType& other) const {
   if (isNull_) {
     return other.isNull_;
   }
+  if (isArray_)
+    return arrayCurrent_ == other.arrayCurrent_;
   return current_ == other.current_;
 #else
   if (isArray_)
@@ -1302,7 +2209,10 @@ bool ValueIteratorBase::isEqual(const SelfType& other) const {
 void ValueIteratorBase::copy(const SelfType& other) {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   current_ = other.current_;
+  arrayBegin_ = other.arrayBegin_;
+  arrayCurrent_ = other.arrayCurrent_;
   isNull_ = other.isNull_;
+  isArray_ = other.isArray_;
 #else
   if (isArray_)
     iterator_.array_ = other.iterator_.array_;
@@ -1312,7 +2222,9 @@ void ValueIteratorBase::copy(const SelfType& other) {
 
 Value ValueIteratorBase::key() const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  const Value::CZString czstring = (*current_).first;
+  if (isArray_)
+    return Value(ArrayIndex(arrayCurrent_ - arrayBegin_));
+  const Value::CZString& czstring = (*current_).first;
   if (czstring.c_str()) {
     if (czstring.isStaticString())
       return Value(StaticString(czstring.c_str()));
@@ -1332,7 +2244,9 @@ Value ValueIteratorBase::key() const {
 
 UInt ValueIteratorBase::index() const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  const Value::CZString czstring = (*current_).first;
+  if (isArray_)
+    return UInt(arrayCurrent_ - arrayBegin_);
+  const Value::CZString& czstring = (*current_).first;
   if (!czstring.c_str())
     return czstring.index();
   return Value::UInt(-1);
@@ -1345,6 +2259,8 @@ UInt ValueIteratorBase::index() const {
 
 const char* ValueIteratorBase::memberName() const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
+  if (isArray_)
+    return "";
   const char* name = (*current_).first.c_str();
   return name ? name : "";
 #else
@@ -1368,6 +2284,11 @@ ValueConstIterator::ValueConstIterator() {}
 ValueConstIterator::ValueConstIterator(
     const Value::ObjectValues::iterator& current)
     : ValueIteratorBase(current) {}
+
+ValueConstIterator::ValueConstIterator(
+    const Value::ArrayValues::iterator& begin,
+    const Value::ArrayValues::iterator& current)
+    : ValueIteratorBase(begin, current) {}
 #else
 ValueConstIterator::ValueConstIterator(
     const ValueInternalArray::IteratorState& state)
@@ -1397,6 +2318,10 @@ ValueIterator::ValueIterator() {}
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
 ValueIterator::ValueIterator(const Value::ObjectValues::iterator& current)
     : ValueIteratorBase(current) {}
+
+ValueIterator::ValueIterator(const Value::ArrayValues::iterator& begin,
+                             const Value::ArrayValues::iterator& current)
+    : ValueIteratorBase(begin, current) {}
 #else
 ValueIterator::ValueIterator(const ValueInternalArray::IteratorState& state)
     : ValueIteratorBase(state) {}
@@ -1453,6 +2378,8 @@ ValueIterator& ValueIterator::operator=(const SelfType& other) {
 #include <cpptl/conststring.h>
 #endif
 #include <cstddef> // size_t
+#include <new>
+#include <tuple>
 
 #define JSON_ASSERT_UNREACHABLE assert(false)
 
@@ -1539,6 +2466,73 @@ static inline char* duplicateStringValue(const char* value,
  */
 static inline void releaseStringValue(char* value) { free(value); }
 
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class Arena
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+static const size_t arenaAlignment = 2 * sizeof(LargestUInt);
+
+static inline size_t alignArenaSize(size_t size) {
+  return (size + arenaAlignment - 1) & ~(arenaAlignment - 1);
+}
+
+Arena::Arena(size_t blockSize)
+    : blocks_(0), current_(0), end_(0),
+      nextBlockSize_(alignArenaSize(blockSize)) {}
+
+Arena::~Arena() {
+  release();
+  free(blocks_);
+}
+
+void* Arena::allocate(size_t size) {
+  size = alignArenaSize(size);
+  if (size > size_t(end_ - current_))
+    grow(size);
+  void* allocated = current_;
+  current_ += size;
+  return allocated;
+}
+
+char* Arena::duplicate(const char* value, size_t length) {
+  char* newString = static_cast<char*>(allocate(length + 1));
+  memcpy(newString, value, length);
+  newString[length] = 0;
+  return newString;
+}
+
+void Arena::release() {
+  // Blocks grow geometrically, so the newest block (the head of the list) is
+  // the largest one; keep it so that documents of a similar size never
+  // allocate again.
+  if (!blocks_)
+    return;
+  while (Block* next = blocks_->next_) {
+    blocks_->next_ = next->next_;
+    free(next);
+  }
+  current_ = reinterpret_cast<char*>(blocks_) + alignArenaSize(sizeof(Block));
+  end_ = current_ + blocks_->size_;
+}
+
+void Arena::grow(size_t size) {
+  size_t blockSize = nextBlockSize_ > size ? nextBlockSize_ : size;
+  nextBlockSize_ = blockSize * 2;
+  Block* block =
+      static_cast<Block*>(malloc(alignArenaSize(sizeof(Block)) + blockSize));
+  JSON_ASSERT_MESSAGE(block != 0,
+                      "in Json::Arena::grow(): Failed to allocate a block");
+  block->next_ = blocks_;
+  block->size_ = blockSize;
+  blocks_ = block;
+  current_ = reinterpret_cast<char*>(block) + alignArenaSize(sizeof(Block));
+  end_ = current_ + blockSize;
+}
+
 } // namespace Json
 
 // //////////////////////////////////////////////////////////////////
@@ -1611,38 +2605,227 @@ Value::CZString::CZString(const CZString& other)
                  ? (other.index_ == noDuplication ? noDuplication : duplicate)
                  : other.index_) {}
 
-Value::CZString::~CZString() {
-  if (cstr_ && index_ == duplicate)
-    releaseStringValue(const_cast<char*>(cstr_));
+Value::CZString::CZString(CZString&& other) noexcept
+    : cstr_(other.cstr_), index_(other.index_) {
+  other.cstr_ = 0;
+}
+
+Value::CZString::~CZString() {
+  if (cstr_ && index_ == duplicate)
+    releaseStringValue(const_cast<char*>(cstr_));
+}
+
+void Value::CZString::swap(CZString& other) {
+  std::swap(cstr_, other.cstr_);
+  std::swap(index_, other.index_);
+}
+
+Value::CZString& Value::CZString::operator=(CZString other) {
+  swap(other);
+  return *this;
+}
+
+bool Value::CZString::operator<(const CZString& other) const {
+  if (cstr_)
+    return strcmp(cstr_, other.cstr_) < 0;
+  return index_ < other.index_;
+}
+
+bool Value::CZString::operator==(const CZString& other) const {
+  if (cstr_)
+    return strcmp(cstr_, other.cstr_) == 0;
+  return index_ == other.index_;
+}
+
+ArrayIndex Value::CZString::index() const { return index_; }
+
+const char* Value::CZString::c_str() const { return cstr_; }
+
+bool Value::CZString::isStaticString() const { return index_ == noDuplication; }
+
+#ifndef JSON_USE_CPPTL_SMALLMAP
+
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class Value::ObjectValues
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+// Objects up to this size are searched by scanning the hashes, larger ones by
+// binary search on the names.
+static const size_t objectLinearSearchLimit = 16;
+
+Value::ObjectValues::ObjectValues(const allocator_type& allocator)
+    : entries_(ArenaAllocator<Entry>(allocator)) {}
+
+Value::ObjectValues::ObjectValues(const ObjectValues& other) : entries_() {
+  entries_.reserve(other.entries_.size());
+  allocator_type allocator;
+  for (size_t index = 0; index < other.entries_.size(); ++index) {
+    value_type* member = allocator.allocate(1);
+    try {
+      new (member) value_type(*other.entries_[index].member_);
+    } catch (...) {
+      allocator.deallocate(member, 1);
+      throw;
+    }
+    Entry entry = {other.entries_[index].hash_, member};
+    entries_.push_back(entry);
+  }
+}
+
+Value::ObjectValues::~ObjectValues() { clear(); }
+
+Value::ObjectValues::allocator_type
+Value::ObjectValues::get_allocator() const {
+  return allocator_type(entries_.get_allocator());
+}
+
+// Mixes the length with the first and last eight bytes of the name, which
+// tells member names apart without a byte by byte loop over long names.
+size_t Value::ObjectValues::hashKey(const char* key) {
+  size_t length = strlen(key);
+  LargestUInt head = 0, tail = 0;
+  memcpy(&head, key, length < 8 ? length : 8);
+  if (length > 8)
+    memcpy(&tail, key + length - 8, 8);
+  LargestUInt hash = (head ^ length) * 0x9E3779B97F4A7C15ULL;
+  hash = (hash ^ (hash >> 29) ^ tail) * 0xBF58476D1CE4E5B9ULL;
+  return size_t(hash ^ (hash >> 32));
+}
+
+// Returns the index of the first member whose name is not less than key.
+size_t Value::ObjectValues::lowerBound(const char* key) const {
+  size_t low = 0, high = entries_.size();
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (strcmp(entries_[middle].member_->first.c_str(), key) < 0)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  return low;
+}
+
+// Returns the index of the member named key, or size() if there is none.
+size_t Value::ObjectValues::findIndex(const char* key, size_t hash) const {
+  size_t count = entries_.size();
+  if (count <= objectLinearSearchLimit) {
+    for (size_t index = 0; index < count; ++index) {
+      const Entry& entry = entries_[index];
+      if (entry.hash_ == hash) {
+        const char* name = entry.member_->first.c_str();
+        if (name == key || strcmp(name, key) == 0)
+          return index;
+      }
+    }
+    return count;
+  }
+  size_t index = lowerBound(key);
+  if (index != count && entries_[index].hash_ == hash &&
+      strcmp(entries_[index].member_->first.c_str(), key) == 0)
+    return index;
+  return count;
+}
+
+Value::ObjectValues::iterator Value::ObjectValues::find(const char* key) {
+  return iterator(entries_.data() + findIndex(key, hashKey(key)));
 }
 
-void Value::CZString::swap(CZString& other) {
-  std::swap(cstr_, other.cstr_);
-  std::swap(index_, other.index_);
+Value::ObjectValues::const_iterator
+Value::ObjectValues::find(const char* key) const {
+  return const_iterator(entries_.data() + findIndex(key, hashKey(key)));
 }
 
-Value::CZString& Value::CZString::operator=(CZString other) {
-  swap(other);
-  return *this;
+Value& Value::ObjectValues::resolve(const char* key, bool isStatic) {
+  size_t hash = hashKey(key);
+  size_t count = entries_.size();
+  size_t index;
+  if (count <= objectLinearSearchLimit) {
+    index = findIndex(key, hash);
+    if (index != count)
+      return entries_[index].member_->second;
+    index = lowerBound(key);
+  } else {
+    index = lowerBound(key);
+    if (index != count && entries_[index].hash_ == hash &&
+        strcmp(entries_[index].member_->first.c_str(), key) == 0)
+      return entries_[index].member_->second;
+  }
+
+  // The entries are kept sorted by name, as the writers emit members in order.
+
+  // Names in an arena object are copied into the arena and never freed.
+  allocator_type allocator = get_allocator();
+  Arena* arena = allocator.arena();
+  value_type* member = allocator.allocate(1);
+  try {
+    if (isStatic)
+      new (member) value_type(
+          std::piecewise_construct,
+          std::forward_as_tuple(key, CZString::noDuplication),
+          std::forward_as_tuple());
+    else if (arena)
+      new (member) value_type(
+          std::piecewise_construct,
+          std::forward_as_tuple(arena->duplicate(key, strlen(key)),
+                                CZString::duplicateOnCopy),
+          std::forward_as_tuple());
+    else
+      new (member) value_type(std::piecewise_construct,
+                              std::forward_as_tuple(key, CZString::duplicate),
+                              std::forward_as_tuple());
+  } catch (...) {
+    allocator.deallocate(member, 1);
+    throw;
+  }
+  Entry entry = {hash, member};
+  try {
+    // Most objects are small; skip growing the index one member at a time.
+    if (entries_.capacity() == 0)
+      entries_.reserve(8);
+    entries_.insert(entries_.begin() + index, entry);
+  } catch (...) {
+    destroy(member);
+    throw;
+  }
+  return member->second;
 }
 
-bool Value::CZString::operator<(const CZString& other) const {
-  if (cstr_)
-    return strcmp(cstr_, other.cstr_) < 0;
-  return index_ < other.index_;
+void Value::ObjectValues::destroy(value_type* member) {
+  member->~value_type();
+  get_allocator().deallocate(member, 1);
 }
 
-bool Value::CZString::operator==(const CZString& other) const {
-  if (cstr_)
-    return strcmp(cstr_, other.cstr_) == 0;
-  return index_ == other.index_;
+void Value::ObjectValues::erase(iterator position) {
+  size_t index = size_t(position.entry_ - entries_.data());
+  destroy(entries_[index].member_);
+  entries_.erase(entries_.begin() + index);
 }
 
-ArrayIndex Value::CZString::index() const { return index_; }
+void Value::ObjectValues::clear() {
+  for (size_t index = 0; index < entries_.size(); ++index)
+    destroy(entries_[index].member_);
+  entries_.clear();
+}
 
-const char* Value::CZString::c_str() const { return cstr_; }
+bool Value::ObjectValues::operator==(const ObjectValues& other) const {
+  if (entries_.size() != other.entries_.size())
+    return false;
+  for (size_t index = 0; index < entries_.size(); ++index)
+    if (!(*entries_[index].member_ == *other.entries_[index].member_))
+      return false;
+  return true;
+}
 
-bool Value::CZString::isStaticString() const { return index_ == noDuplication; }
+bool Value::ObjectValues::operator<(const ObjectValues& other) const {
+  return std::lexicographical_compare(begin(), end(), other.begin(),
+                                      other.end());
+}
+
+#endif // ifndef JSON_USE_CPPTL_SMALLMAP
 
 #endif // ifndef JSON_VALUE_USE_INTERNAL_MAP
 
@@ -1668,9 +2851,10 @@ Value::Value(ValueType type)
       comments_(0), start_(0), limit_(0) {
   switch (type) {
   case nullValue:
-    break;
   case intValue:
   case uintValue:
+    // A null value is swapped whole by operator=, so its payload is
+    // initialized as well.
     value_.int_ = 0;
     break;
   case realValue:
@@ -1681,8 +2865,12 @@ Value::Value(ValueType type)
     break;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
+    value_.array_ = new ArrayValues();
+    allocated_ = true;
+    break;
   case objectValue:
     value_.map_ = new ObjectValues();
+    allocated_ = true;
     break;
 #else
   case arrayValue:
@@ -1827,6 +3015,45 @@ Value::Value(bool value)
   value_.bool_ = value;
 }
 
+Value::Value(ValueType type, Arena& arena)
+    : type_(nullValue), allocated_(false)
+#ifdef JSON_VALUE_USE_INTERNAL_MAP
+      ,
+      itemIsUsed_(0)
+#endif
+      ,
+      comments_(0), start_(0), limit_(0) {
+  value_.uint_ = 0;
+  switch (type) {
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+  case arrayValue:
+    type_ = arrayValue;
+    value_.array_ =
+        new (arena.allocate(sizeof(ArrayValues))) ArrayValues(&arena);
+    break;
+  case objectValue:
+    type_ = objectValue;
+    value_.map_ =
+        new (arena.allocate(sizeof(ObjectValues))) ObjectValues(&arena);
+    break;
+#endif
+  default:
+    // Nothing else is stored in the arena.
+    Value(type).swap(*this);
+  }
+}
+
+Value::Value(const char* beginValue, const char* endValue, Arena& arena)
+    : type_(stringValue), allocated_(false)
+#ifdef JSON_VALUE_USE_INTERNAL_MAP
+      ,
+      itemIsUsed_(0)
+#endif
+      ,
+      comments_(0), start_(0), limit_(0) {
+  value_.string_ = arena.duplicate(beginValue, endValue - beginValue);
+}
+
 Value::Value(const Value& other)
     : type_(other.type_), allocated_(false)
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
@@ -1854,8 +3081,12 @@ Value::Value(const Value& other)
     break;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
+    value_.array_ = new ArrayValues(*other.value_.array_);
+    allocated_ = true;
+    break;
   case objectValue:
     value_.map_ = new ObjectValues(*other.value_.map_);
+    allocated_ = true;
     break;
 #else
   case arrayValue:
@@ -1878,6 +3109,20 @@ Value::Value(const Value& other)
   }
 }
 
+Value::Value(Value&& other) noexcept
+    : type_(other.type_), allocated_(other.allocated_)
+#ifdef JSON_VALUE_USE_INTERNAL_MAP
+      ,
+      itemIsUsed_(0)
+#endif
+      ,
+      comments_(other.comments_), start_(other.start_), limit_(other.limit_) {
+  value_ = other.value_;
+  other.type_ = nullValue;
+  other.allocated_ = false;
+  other.comments_ = 0;
+}
+
 Value::~Value() {
   switch (type_) {
   case nullValue:
@@ -1891,9 +3136,15 @@ Value::~Value() {
       releaseStringValue(value_.string_);
     break;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
+  // Containers in an arena are dropped with the arena, along with everything
+  // they hold.
   case arrayValue:
+    if (allocated_)
+      delete value_.array_;
+    break;
   case objectValue:
-    delete value_.map_;
+    if (allocated_)
+      delete value_.map_;
     break;
 #else
   case arrayValue:
@@ -1958,7 +3209,12 @@ bool Value::operator<(const Value& other) const {
            (other.value_.string_ && value_.string_ &&
             strcmp(value_.string_, other.value_.string_) < 0);
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  case arrayValue:
+  case arrayValue: {
+    int delta = int(value_.array_->size() - other.value_.array_->size());
+    if (delta)
+      return delta < 0;
+    return (*value_.array_) < (*other.value_.array_);
+  }
   case objectValue: {
     int delta = int(value_.map_->size() - other.value_.map_->size());
     if (delta)
@@ -2008,6 +3264,8 @@ bool Value::operator==(const Value& other) const {
             strcmp(value_.string_, other.value_.string_) == 0);
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
+    return value_.array_->size() == other.value_.array_->size() &&
+           (*value_.array_) == (*other.value_.array_);
   case objectValue:
     return value_.map_->size() == other.value_.map_->size() &&
            (*value_.map_) == (*other.value_.map_);
@@ -2229,7 +3487,7 @@ bool Value::isConvertibleTo(ValueType other) const {
     return (isNumeric() && asDouble() == 0.0) ||
            (type_ == booleanValue && value_.bool_ == false) ||
            (type_ == stringValue && asString() == "") ||
-           (type_ == arrayValue && value_.map_->size() == 0) ||
+           (type_ == arrayValue && size() == 0) ||
            (type_ == objectValue && value_.map_->size() == 0) ||
            type_ == nullValue;
   case intValue:
@@ -2267,13 +3525,8 @@ ArrayIndex Value::size() const {
   case stringValue:
     return 0;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  case arrayValue: // size of the array is highest index + 1
-    if (!value_.map_->empty()) {
-      ObjectValues::const_iterator itLast = value_.map_->end();
-      --itLast;
-      return (*itLast).first.index() + 1;
-    }
-    return 0;
+  case arrayValue:
+    return ArrayIndex(value_.array_->size());
   case objectValue:
     return ArrayIndex(value_.map_->size());
 #else
@@ -2305,6 +3558,8 @@ void Value::clear() {
   switch (type_) {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
+    value_.array_->clear();
+    break;
   case objectValue:
     value_.map_->clear();
     break;
@@ -2327,22 +3582,27 @@ void Value::resize(ArrayIndex newSize) {
   if (type_ == nullValue)
     *this = Value(arrayValue);
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  ArrayIndex oldSize = size();
   if (newSize == 0)
     clear();
-  else if (newSize > oldSize)
-    (*this)[newSize - 1];
-  else {
-    for (ArrayIndex index = newSize; index < oldSize; ++index) {
-      value_.map_->erase(index);
-    }
-    assert(size() == newSize);
-  }
+  else
+    resizeArray(newSize);
 #else
   value_.array_->resize(newSize);
 #endif
 }
 
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+// Grows the array geometrically so that append() is amortized O(1). The
+// move constructor is noexcept, so reallocation moves the elements instead of
+// deep-copying every nested array and object.
+void Value::resizeArray(ArrayIndex newSize) {
+  ArrayValues& array = *value_.array_;
+  if (newSize > array.capacity())
+    array.reserve(std::max<size_t>(newSize, array.capacity() * 2));
+  array.resize(newSize);
+}
+#endif
+
 Value& Value::operator[](ArrayIndex index) {
   JSON_ASSERT_MESSAGE(
       type_ == nullValue || type_ == arrayValue,
@@ -2350,14 +3610,9 @@ Value& Value::operator[](ArrayIndex index) {
   if (type_ == nullValue)
     *this = Value(arrayValue);
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  CZString key(index);
-  ObjectValues::iterator it = value_.map_->lower_bound(key);
-  if (it != value_.map_->end() && (*it).first == key)
-    return (*it).second;
-
-  ObjectValues::value_type defaultValue(key, null);
-  it = value_.map_->insert(it, defaultValue);
-  return (*it).second;
+  if (index >= value_.array_->size())
+    resizeArray(index + 1);
+  return (*value_.array_)[index];
 #else
   return value_.array_->resolveReference(index);
 #endif
@@ -2377,11 +3632,9 @@ const Value& Value::operator[](ArrayIndex index) const {
   if (type_ == nullValue)
     return null;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  CZString key(index);
-  ObjectValues::const_iterator it = value_.map_->find(key);
-  if (it == value_.map_->end())
+  if (index >= value_.array_->size())
     return null;
-  return (*it).second;
+  return (*value_.array_)[index];
 #else
   Value* value = value_.array_->find(index);
   return value ? *value : null;
@@ -2406,16 +3659,7 @@ Value& Value::resolveReference(const char* key, bool isStatic) {
   if (type_ == nullValue)
     *this = Value(objectValue);
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  CZString actualKey(
-      key, isStatic ? CZString::noDuplication : CZString::duplicateOnCopy);
-  ObjectValues::iterator it = value_.map_->lower_bound(actualKey);
-  if (it != value_.map_->end() && (*it).first == actualKey)
-    return (*it).second;
-
-  ObjectValues::value_type defaultValue(actualKey, null);
-  it = value_.map_->insert(it, defaultValue);
-  Value& value = (*it).second;
-  return value;
+  return value_.map_->resolve(key, isStatic);
 #else
   return value_.map_->resolveReference(key, isStatic);
 #endif
@@ -2435,8 +3679,7 @@ const Value& Value::operator[](const char* key) const {
   if (type_ == nullValue)
     return null;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  CZString actualKey(key, CZString::noDuplication);
-  ObjectValues::const_iterator it = value_.map_->find(actualKey);
+  ObjectValues::const_iterator it = value_.map_->find(key);
   if (it == value_.map_->end())
     return null;
   return (*it).second;
@@ -2470,6 +3713,10 @@ const Value& Value::operator[](const CppTL::ConstString& key) const {
 
 Value& Value::append(const Value& value) { return (*this)[size()] = value; }
 
+Value& Value::append(Value&& value) {
+  return (*this)[size()] = std::move(value);
+}
+
 Value Value::get(const char* key, const Value& defaultValue) const {
   const Value* value = &((*this)[key]);
   return value == &null ? defaultValue : *value;
@@ -2485,11 +3732,13 @@ Value Value::removeMember(const char* key) {
   if (type_ == nullValue)
     return null;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  CZString actualKey(key, CZString::noDuplication);
-  ObjectValues::iterator it = value_.map_->find(actualKey);
+  ObjectValues::iterator it = value_.map_->find(key);
   if (it == value_.map_->end())
     return null;
-  Value old(it->second);
+  // A member of an arena document is copied so that it outlives the arena.
+  Value old = value_.map_->get_allocator().arena()
+                  ? Value(it->second)
+                  : Value(std::move(it->second));
   value_.map_->erase(it);
   return old;
 #else
@@ -2728,6 +3977,9 @@ Value::const_iterator Value::begin() const {
     break;
 #else
   case arrayValue:
+    if (value_.array_)
+      return const_iterator(value_.array_->begin(), value_.array_->begin());
+    break;
   case objectValue:
     if (value_.map_)
       return const_iterator(value_.map_->begin());
@@ -2758,6 +4010,9 @@ Value::const_iterator Value::end() const {
     break;
 #else
   case arrayValue:
+    if (value_.array_)
+      return const_iterator(value_.array_->begin(), value_.array_->end());
+    break;
   case objectValue:
     if (value_.map_)
       return const_iterator(value_.map_->end());
@@ -2788,6 +4043,9 @@ Value::iterator Value::begin() {
     break;
 #else
   case arrayValue:
+    if (value_.array_)
+      return iterator(value_.array_->begin(), value_.array_->begin());
+    break;
   case objectValue:
     if (value_.map_)
       return iterator(value_.map_->begin());
@@ -2818,6 +4076,9 @@ Value::iterator Value::end() {
     break;
 #else
   case arrayValue:
+    if (value_.array_)
+      return iterator(value_.array_->begin(), value_.array_->end());
+    break;
   case objectValue:
     if (value_.map_)
       return iterator(value_.map_->end());
@@ -2997,10 +4258,17 @@ Value& Path::make(Value& root) const {
 #include <utility>
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sstream>
 #include <iomanip>
 #include <math.h>
+#include <errno.h>
+#if defined(_MSC_VER)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 #if defined(_MSC_VER) && _MSC_VER < 1500 // VC++ 8.0 and below
 #include <float.h>
@@ -3015,33 +4283,43 @@ Value& Path::make(Value& root) const {
 
 namespace Json {
 
-static bool containsControlCharacter(const char* str) {
-  while (*str) {
-    if (isControlCharacter(*(str++)))
-      return true;
-  }
-  return false;
-}
-
-std::string valueToString(LargestInt value) {
-  UIntToStringBuffer buffer;
-  char* current = buffer + sizeof(buffer);
+/// Formats value into buffer, returning the length of the text. buffer must
+/// have room for uintToStringBufferSize chars.
+static int integerToChars(LargestInt value, char* buffer) {
+  char* end = buffer + uintToStringBufferSize;
+  char* current = end;
   bool isNegative = value < 0;
-  if (isNegative)
-    value = -value;
-  uintToString(LargestUInt(value), current);
+  uintToString(isNegative ? LargestUInt(0) - LargestUInt(value)
+                          : LargestUInt(value),
+               current);
   if (isNegative)
     *--current = '-';
   assert(current >= buffer);
-  return current;
+  int length = int(end - 1 - current);
+  memmove(buffer, current, length + 1);
+  return length;
 }
 
-std::string valueToString(LargestUInt value) {
-  UIntToStringBuffer buffer;
-  char* current = buffer + sizeof(buffer);
+static int integerToChars(LargestUInt value, char* buffer) {
+  char* end = buffer + uintToStringBufferSize;
+  char* current = end;
   uintToString(value, current);
   assert(current >= buffer);
-  return current;
+  int length = int(end - 1 - current);
+  memmove(buffer, current, length + 1);
+  return length;
+}
+
+std::string valueToString(LargestInt value) {
+  UIntToStringBuffer buffer;
+  int length = integerToChars(value, buffer);
+  return std::string(buffer, length);
+}
+
+std::string valueToString(LargestUInt value) {
+  UIntToStringBuffer buffer;
+  int length = integerToChars(value, buffer);
+  return std::string(buffer, length);
 }
 
 #if defined(JSON_HAS_INT64)
@@ -3056,82 +4334,139 @@ std::string valueToString(UInt value) {
 
 #endif // # if defined(JSON_HAS_INT64)
 
-std::string valueToString(double value) {
-  // Allocate a buffer that is more than large enough to store the 16 digits of
-  // precision requested below.
-  char buffer[32];
-  int len = -1;
-
-// Print into the buffer. We need not request the alternative representation
-// that always has a decimal point because JSON doesn't distingish the
-// concepts of reals and integers.
+/// Formats value with the given number of significant digits ("%.*g").
+static int formatDouble(char* buffer, size_t size, int precision,
+                        double value) {
 #if defined(_MSC_VER) && defined(__STDC_SECURE_LIB__) // Use secure version with
                                                       // visual studio 2005 to
                                                       // avoid warning.
 #if defined(WINCE)
-  len = _snprintf(buffer, sizeof(buffer), "%.16g", value);
+  return _snprintf(buffer, size, "%.*g", precision, value);
 #else
-  len = sprintf_s(buffer, sizeof(buffer), "%.16g", value);
+  return sprintf_s(buffer, size, "%.*g", precision, value);
 #endif
 #else
+  return snprintf(buffer, size, "%.*g", precision, value);
+#endif
+}
+
+/// Formats value into buffer, which must have room for 32 chars, returning
+/// the length of the text.
+static int realToChars(double value, char* buffer) {
+  const size_t size = 32;
+  int len = -1;
+
+  // Print into the buffer. We need not request the alternative representation
+  // that always has a decimal point because JSON doesn't distingish the
+  // concepts of reals and integers.
   if (isfinite(value)) {
-    len = snprintf(buffer, sizeof(buffer), "%.16g", value);
+    // Use the fewest significant digits that read back as the same double:
+    // 0.1 stays "0.1", and any value round-trips since 17 digits always do.
+    // %g drops trailing zeros, so for normal numbers 15 digits also covers
+    // shorter forms. The check reads the buffer back with the reader's fast
+    // path, or with strtod, which uses the same locale as the formatting.
+    for (int precision = 15; precision <= 17; ++precision) {
+      len = formatDouble(buffer, size, precision, value);
+      if (precision == 17)
+        break;
+      double parsed;
+      if (!decimalToDouble(buffer, buffer + len, parsed))
+        parsed = strtod(buffer, 0);
+      if (parsed == value)
+        break;
+    }
   } else {
     // IEEE standard states that NaN values will not compare to themselves
     if (value != value) {
-      len = snprintf(buffer, sizeof(buffer), "null");
+      len = snprintf(buffer, size, "null");
     } else if (value < 0) {
-      len = snprintf(buffer, sizeof(buffer), "-1e+9999");
+      len = snprintf(buffer, size, "-1e+9999");
     } else {
-      len = snprintf(buffer, sizeof(buffer), "1e+9999");
+      len = snprintf(buffer, size, "1e+9999");
     }
     // For those, we do not need to call fixNumLoc, but it is fast.
   }
-#endif
   assert(len >= 0);
   fixNumericLocale(buffer, buffer + len);
-  return buffer;
+  return len;
+}
+
+std::string valueToString(double value) {
+  // Allocate a buffer that is more than large enough to store the 17 digits of
+  // precision requested in realToChars().
+  char buffer[32];
+  int len = realToChars(value, buffer);
+  return std::string(buffer, len);
 }
 
 std::string valueToString(bool value) { return value ? "true" : "false"; }
 
-std::string valueToQuotedString(const char* value) {
+/// Returns true if c must be escaped in a JSON string.
+static inline bool needsEscape(char c) {
+  return static_cast<unsigned char>(c) < 0x20 || c == '"' || c == '\\';
+}
+
+/// Returns the first character in [current, end) that must be escaped, or
+/// end. Tests 16 bytes at a time with SSE2 where the reader does.
+static const char* findEscape(const char* current, const char* end) {
+#if defined(JSON_READER_SSE2)
+  const __m128i quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\'),
+                lastControl = _mm_set1_epi8(0x1F);
+  for (; end - current >= 16; current += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+    // A byte is a control character if the unsigned minimum with 0x1F leaves
+    // it unchanged.
+    __m128i escapes = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                     _mm_cmpeq_epi8(chunk, backslash)),
+        _mm_cmpeq_epi8(_mm_min_epu8(chunk, lastControl), chunk));
+    unsigned int mask = unsigned(_mm_movemask_epi8(escapes));
+    if (mask)
+      return current + countTrailingZeros(mask);
+  }
+#endif
+  while (current != end && !needsEscape(*current))
+    ++current;
+  return current;
+}
+
+/// Writes value as a quoted JSON string. Runs of characters that need no
+/// escape are copied in one piece. Writes nothing if value is NULL.
+static void writeQuotedString(OutputBuffer& out, const char* value) {
   if (value == NULL)
-    return "";
-  // Not sure how to handle unicode...
-  if (strpbrk(value, "\"\\\b\f\n\r\t") == NULL &&
-      !containsControlCharacter(value))
-    return std::string("\"") + value + "\"";
-  // We have to walk value and escape any special characters.
-  // Appending to std::string is not efficient, but this should be rare.
-  // (Note: forward slashes are *not* rare, but I am not escaping them.)
-  std::string::size_type maxsize =
-      strlen(value) * 2 + 3; // allescaped+quotes+NULL
-  std::string result;
-  result.reserve(maxsize); // to avoid lots of mallocs
-  result += "\"";
-  for (const char* c = value; *c != 0; ++c) {
-    switch (*c) {
+    return;
+  static const char hex[] = "0123456789ABCDEF";
+  const char* current = value;
+  const char* end = value + strlen(value);
+  out.write('"');
+  for (;;) {
+    const char* run = current;
+    current = findEscape(current, end);
+    out.write(run, size_t(current - run));
+    if (current == end)
+      break;
+    char c = *current++;
+    switch (c) {
     case '\"':
-      result += "\\\"";
+      out.write("\\\"", 2);
       break;
     case '\\':
-      result += "\\\\";
+      out.write("\\\\", 2);
       break;
     case '\b':
-      result += "\\b";
+      out.write("\\b", 2);
       break;
     case '\f':
-      result += "\\f";
+      out.write("\\f", 2);
       break;
     case '\n':
-      result += "\\n";
+      out.write("\\n", 2);
       break;
     case '\r':
-      result += "\\r";
+      out.write("\\r", 2);
       break;
     case '\t':
-      result += "\\t";
+      out.write("\\t", 2);
       break;
     // case '/':
     // Even though \/ is considered a legal escape in JSON, a bare
@@ -3141,31 +4476,80 @@ std::string valueToQuotedString(const char* value) {
     // sequence.
     // Should add a flag to allow this compatibility mode and prevent this
     // sequence from occurring.
-    default:
-      if (isControlCharacter(*c)) {
-        std::ostringstream oss;
-        oss << "\\u" << std::hex << std::uppercase << std::setfill('0')
-            << std::setw(4) << static_cast<int>(*c);
-        result += oss.str();
-      } else {
-        result += *c;
-      }
-      break;
+    default: {
+      const char escape[6] = {'\\', 'u', '0', '0', hex[(c >> 4) & 0xF],
+                              hex[c & 0xF]};
+      out.write(escape, sizeof(escape));
+    } break;
     }
   }
-  result += "\"";
+  out.write('"');
+}
+
+std::string valueToQuotedString(const char* value) {
+  std::string result;
+  OutputBuffer out(result);
+  writeQuotedString(out, value);
   return result;
 }
 
+// Class OutputBuffer
+// //////////////////////////////////////////////////////////////////
+
+OutputBuffer::OutputBuffer(std::string& document)
+    : output_(&document), capacity_(std::string::npos), fd_(-1), last_(0),
+      toDocument_(true), failed_(false) {}
+
+// A negative fd, e.g. from a failed open(), fails like a failed write: the
+// output is discarded at each flush() instead of piling up.
+OutputBuffer::OutputBuffer(int fd, size_t capacity)
+    : output_(&buffer_), capacity_(capacity), fd_(fd), last_(0),
+      toDocument_(false), failed_(fd < 0) {
+  buffer_.reserve(capacity);
+}
+
+OutputBuffer::~OutputBuffer() { flush(); }
+
+bool OutputBuffer::flush() {
+  if (toDocument_)
+    return true;
+  if (buffer_.empty())
+    return !failed_;
+  last_ = buffer_[buffer_.size() - 1];
+  const char* data = buffer_.data();
+  size_t left = buffer_.size();
+  while (left != 0 && !failed_) {
+#if defined(_MSC_VER)
+    int written = _write(fd_, data, unsigned(left));
+#else
+    ssize_t written = ::write(fd_, data, left);
+    if (written < 0 && errno == EINTR)
+      continue;
+#endif
+    if (written <= 0)
+      failed_ = true;
+    else {
+      data += written;
+      left -= size_t(written);
+    }
+  }
+  buffer_.clear();
+  return !failed_;
+}
+
 // Class Writer
 // //////////////////////////////////////////////////////////////////
 Writer::~Writer() {}
 
+void Writer::write(OutputBuffer& out, const Value& root) {
+  out.write(write(root));
+}
+
 // Class FastWriter
 // //////////////////////////////////////////////////////////////////
 
 FastWriter::FastWriter()
-    : yamlCompatiblityEnabled_(false), dropNullPlaceholders_(false),
+    : out_(0), yamlCompatiblityEnabled_(false), dropNullPlaceholders_(false),
       omitEndingLineFeed_(false) {}
 
 void FastWriter::enableYAMLCompatibility() { yamlCompatiblityEnabled_ = true; }
@@ -3175,57 +4559,72 @@ void FastWriter::dropNullPlaceholders() { dropNullPlaceholders_ = true; }
 void FastWriter::omitEndingLineFeed() { omitEndingLineFeed_ = true; }
 
 std::string FastWriter::write(const Value& root) {
-  document_ = "";
+  document_.clear();
+  {
+    OutputBuffer out(document_);
+    write(out, root);
+  }
+  return document_;
+}
+
+void FastWriter::write(OutputBuffer& out, const Value& root) {
+  out_ = &out;
   writeValue(root);
   if (!omitEndingLineFeed_)
-    document_ += "\n";
-  return document_;
+    out.write('\n');
+  out_ = 0;
 }
 
 void FastWriter::writeValue(const Value& value) {
   switch (value.type()) {
   case nullValue:
     if (!dropNullPlaceholders_)
-      document_ += "null";
-    break;
-  case intValue:
-    document_ += valueToString(value.asLargestInt());
-    break;
-  case uintValue:
-    document_ += valueToString(value.asLargestUInt());
-    break;
-  case realValue:
-    document_ += valueToString(value.asDouble());
+      out_->write("null", 4);
     break;
+  case intValue: {
+    UIntToStringBuffer buffer;
+    out_->write(buffer, integerToChars(value.asLargestInt(), buffer));
+  } break;
+  case uintValue: {
+    UIntToStringBuffer buffer;
+    out_->write(buffer, integerToChars(value.asLargestUInt(), buffer));
+  } break;
+  case realValue: {
+    char buffer[32];
+    out_->write(buffer, realToChars(value.asDouble(), buffer));
+  } break;
   case stringValue:
-    document_ += valueToQuotedString(value.asCString());
+    writeQuotedString(*out_, value.asCString());
     break;
   case booleanValue:
-    document_ += valueToString(value.asBool());
+    if (value.asBool())
+      out_->write("true", 4);
+    else
+      out_->write("false", 5);
     break;
   case arrayValue: {
-    document_ += "[";
+    out_->write('[');
     int size = value.size();
     for (int index = 0; index < size; ++index) {
       if (index > 0)
-        document_ += ",";
+        out_->write(',');
       writeValue(value[index]);
     }
-    document_ += "]";
+    out_->write(']');
   } break;
   case objectValue: {
-    Value::Members members(value.getMemberNames());
-    document_ += "{";
-    for (Value::Members::iterator it = members.begin(); it != members.end();
-         ++it) {
-      const std::string& name = *it;
-      if (it != members.begin())
-        document_ += ",";
-      document_ += valueToQuotedString(name.c_str());
-      document_ += yamlCompatiblityEnabled_ ? ": " : ":";
-      writeValue(value[name]);
+    out_->write('{');
+    for (Value::const_iterator it = value.begin(); it != value.end(); ++it) {
+      if (it != value.begin())
+        out_->write(',');
+      writeQuotedString(*out_, it.memberName());
+      if (yamlCompatiblityEnabled_)
+        out_->write(": ", 2);
+      else
+        out_->write(':');
+      writeValue(*it);
     }
-    document_ += "}";
+    out_->write('}');
   } break;
   }
 }
@@ -3234,66 +4633,86 @@ void FastWriter::writeValue(const Value& value) {
 // //////////////////////////////////////////////////////////////////
 
 StyledWriter::StyledWriter()
-    : rightMargin_(74), indentSize_(3), addChildValues_() {}
+    : out_(0), indentation_(0), rightMargin_(74), indentSize_(3),
+      addChildValues_() {}
 
 std::string StyledWriter::write(const Value& root) {
-  document_ = "";
+  document_.clear();
+  {
+    OutputBuffer out(document_);
+    write(out, root);
+  }
+  return document_;
+}
+
+void StyledWriter::write(OutputBuffer& out, const Value& root) {
+  out_ = &out;
   addChildValues_ = false;
-  indentString_ = "";
+  indentation_ = 0;
   writeCommentBeforeValue(root);
   writeValue(root);
   writeCommentAfterValueOnSameLine(root);
-  document_ += "\n";
-  return document_;
+  out.write('\n');
+  out_ = 0;
 }
 
 void StyledWriter::writeValue(const Value& value) {
   switch (value.type()) {
   case nullValue:
-    pushValue("null");
-    break;
-  case intValue:
-    pushValue(valueToString(value.asLargestInt()));
-    break;
-  case uintValue:
-    pushValue(valueToString(value.asLargestUInt()));
-    break;
-  case realValue:
-    pushValue(valueToString(value.asDouble()));
+    pushValue("null", 4);
     break;
+  case intValue: {
+    UIntToStringBuffer buffer;
+    pushValue(buffer, integerToChars(value.asLargestInt(), buffer));
+  } break;
+  case uintValue: {
+    UIntToStringBuffer buffer;
+    pushValue(buffer, integerToChars(value.asLargestUInt(), buffer));
+  } break;
+  case realValue: {
+    char buffer[32];
+    pushValue(buffer, realToChars(value.asDouble(), buffer));
+  } break;
   case stringValue:
-    pushValue(valueToQuotedString(value.asCString()));
+    if (addChildValues_) {
+      OutputBuffer child(childValues_);
+      writeQuotedString(child, value.asCString());
+      childEnds_.push_back(childValues_.size());
+    } else
+      writeQuotedString(*out_, value.asCString());
     break;
   case booleanValue:
-    pushValue(valueToString(value.asBool()));
+    if (value.asBool())
+      pushValue("true", 4);
+    else
+      pushValue("false", 5);
     break;
   case arrayValue:
     writeArrayValue(value);
     break;
   case objectValue: {
-    Value::Members members(value.getMemberNames());
-    if (members.empty())
-      pushValue("{}");
+    if (value.empty())
+      pushValue("{}", 2);
     else {
-      writeWithIndent("{");
+      writeWithIndent("{", 1);
       indent();
-      Value::Members::iterator it = members.begin();
+      Value::const_iterator it = value.begin();
       for (;;) {
-        const std::string& name = *it;
-        const Value& childValue = value[name];
+        const Value& childValue = *it;
         writeCommentBeforeValue(childValue);
-        writeWithIndent(valueToQuotedString(name.c_str()));
-        document_ += " : ";
+        writeIndent();
+        writeQuotedString(*out_, it.memberName());
+        out_->write(" : ", 3);
         writeValue(childValue);
-        if (++it == members.end()) {
+        if (++it == value.end()) {
           writeCommentAfterValueOnSameLine(childValue);
           break;
         }
-        document_ += ",";
+        out_->write(',');
         writeCommentAfterValueOnSameLine(childValue);
       }
       unindent();
-      writeWithIndent("}");
+      writeWithIndent("}", 1);
     }
   } break;
   }
@@ -3302,20 +4721,23 @@ void StyledWriter::writeValue(const Value& value) {
 void StyledWriter::writeArrayValue(const Value& value) {
   unsigned size = value.size();
   if (size == 0)
-    pushValue("[]");
+    pushValue("[]", 2);
   else {
     bool isArrayMultiLine = isMultineArray(value);
     if (isArrayMultiLine) {
-      writeWithIndent("[");
+      writeWithIndent("[", 1);
       indent();
-      bool hasChildValue = !childValues_.empty();
+      bool hasChildValue = !childEnds_.empty();
       unsigned index = 0;
+      size_t childBegin = 0;
       for (;;) {
         const Value& childValue = value[index];
         writeCommentBeforeValue(childValue);
-        if (hasChildValue)
-          writeWithIndent(childValues_[index]);
-        else {
+        if (hasChildValue) {
+          writeWithIndent(childValues_.data() + childBegin,
+                          childEnds_[index] - childBegin);
+          childBegin = childEnds_[index];
+        } else {
           writeIndent();
           writeValue(childValue);
         }
@@ -3323,21 +4745,24 @@ void StyledWriter::writeArrayValue(const Value& value) {
           writeCommentAfterValueOnSameLine(childValue);
           break;
         }
-        document_ += ",";
+        out_->write(',');
         writeCommentAfterValueOnSameLine(childValue);
       }
       unindent();
-      writeWithIndent("]");
+      writeWithIndent("]", 1);
     } else // output on a single line
     {
-      assert(childValues_.size() == size);
-      document_ += "[ ";
+      assert(childEnds_.size() == size);
+      out_->write("[ ", 2);
+      size_t childBegin = 0;
       for (unsigned index = 0; index < size; ++index) {
         if (index > 0)
-          document_ += ", ";
-        document_ += childValues_[index];
+          out_->write(", ", 2);
+        out_->write(childValues_.data() + childBegin,
+                    childEnds_[index] - childBegin);
+        childBegin = childEnds_[index];
       }
-      document_ += " ]";
+      out_->write(" ]", 2);
     }
   }
 }
@@ -3346,6 +4771,7 @@ bool StyledWriter::isMultineArray(const Value& value) {
   int size = value.size();
   bool isMultiLine = size * 3 >= rightMargin_;
   childValues_.clear();
+  childEnds_.clear();
   for (int index = 0; index < size && !isMultiLine; ++index) {
     const Value& childValue = value[index];
     isMultiLine =
@@ -3354,76 +4780,81 @@ bool StyledWriter::isMultineArray(const Value& value) {
   }
   if (!isMultiLine) // check if line length > max line length
   {
-    childValues_.reserve(size);
+    childEnds_.reserve(size);
     addChildValues_ = true;
-    int lineLength = 4 + (size - 1) * 2; // '[ ' + ', '*n + ' ]'
-    for (int index = 0; index < size; ++index) {
+    for (int index = 0; index < size; ++index)
       writeValue(value[index]);
-      lineLength += int(childValues_[index].length());
-    }
     addChildValues_ = false;
+    int lineLength = 4 + (size - 1) * 2; // '[ ' + ', '*n + ' ]'
+    lineLength += int(childValues_.size());
     isMultiLine = isMultiLine || lineLength >= rightMargin_;
   }
   return isMultiLine;
 }
 
-void StyledWriter::pushValue(const std::string& value) {
-  if (addChildValues_)
-    childValues_.push_back(value);
-  else
-    document_ += value;
+void StyledWriter::pushValue(const char* value, size_t length) {
+  if (addChildValues_) {
+    childValues_.append(value, length);
+    childEnds_.push_back(childValues_.size());
+  } else
+    out_->write(value, length);
 }
 
 void StyledWriter::writeIndent() {
-  if (!document_.empty()) {
-    char last = document_[document_.length() - 1];
+  char last = out_->last();
+  if (last) {
     if (last == ' ') // already indented
       return;
     if (last != '\n') // Comments may add new-line
-      document_ += '\n';
+      out_->write('\n');
   }
-  document_ += indentString_;
+  static const char spaces[] = "                                ";
+  const int spaceCount = int(sizeof(spaces)) - 1;
+  for (int left = indentation_; left > 0; left -= spaceCount)
+    out_->write(spaces, size_t(left < spaceCount ? left : spaceCount));
 }
 
-void StyledWriter::writeWithIndent(const std::string& value) {
+void StyledWriter::writeWithIndent(const char* value, size_t length) {
   writeIndent();
-  document_ += value;
+  out_->write(value, length);
 }
 
-void StyledWriter::indent() { indentString_ += std::string(indentSize_, ' '); }
+void StyledWriter::indent() { indentation_ += indentSize_; }
 
 void StyledWriter::unindent() {
-  assert(int(indentString_.size()) >= indentSize_);
-  indentString_.resize(indentString_.size() - indentSize_);
+  assert(indentation_ >= indentSize_);
+  indentation_ -= indentSize_;
 }
 
 void StyledWriter::writeCommentBeforeValue(const Value& root) {
   if (!root.hasComment(commentBefore))
     return;
 
-  document_ += "\n";
+  out_->write('\n');
   writeIndent();
   std::string normalizedComment = normalizeEOL(root.getComment(commentBefore));
   std::string::const_iterator iter = normalizedComment.begin();
   while (iter != normalizedComment.end()) {
-    document_ += *iter;
+    out_->write(*iter);
     if (*iter == '\n' && *(iter + 1) == '/')
       writeIndent();
     ++iter;
   }
 
   // Comments are stripped of newlines, so add one here
-  document_ += "\n";
+  out_->write('\n');
 }
 
 void StyledWriter::writeCommentAfterValueOnSameLine(const Value& root) {
-  if (root.hasComment(commentAfterOnSameLine))
-    document_ += " " + normalizeEOL(root.getComment(commentAfterOnSameLine));
+  if (root.hasComment(commentAfterOnSameLine)) {
+    out_->write(' ');
+    out_->write(normalizeEOL(root.getComment(commentAfterOnSameLine)));
+  }
 
   if (root.hasComment(commentAfter)) {
-    document_ += "\n";
-    document_ += normalizeEOL(root.getComment(commentAfter));
-    document_ += "\n";
+    out_->write('\n');
+    out_->write(normalizeEOL(root.getComment(commentAfter)));
+    out_->write('\n');
   }
 }
 
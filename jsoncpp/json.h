@@ -256,6 +256,8 @@ class StyledWriter;
 
 // reader.h
 class Reader;
+class LazyDocument;
+class LazyValue;
 
 // features.h
 class Features;
@@ -325,10 +327,18 @@ public:
    * specification.
    * - Comments are forbidden.
    * - Root object must be either an array or an object value.
-   * - Assumes Value strings are encoded in UTF-8
+   * - Strings must be valid UTF-8
    */
   static Features strictMode();
 
+  /** \brief A configuration for trusted, machine-generated documents that
+   * keeps only the work needed to build the values.
+   * - Comments are forbidden.
+   * - Values do not record their offsets in the document.
+   * - Parsing stops at the first error.
+   */
+  static Features fast();
+
   /** \brief Initialize the configuration like JsonConfig::allFeatures;
    */
   Features();
@@ -345,6 +355,22 @@ public:
 
   /// \c true if numeric object key are allowed. Default: \c false.
   bool allowNumericKeys_;
+
+  /// \c true if strings must be well-formed UTF-8 (no overlong forms,
+  /// surrogates or code points above U+10FFFF). Default: \c false.
+  bool validateUTF8_;
+
+  /// \c true if each value records where it starts and ends in the document
+  /// (Value::getOffsetStart() and getOffsetLimit()). Default: \c true.
+  bool trackOffsets_;
+
+  /// \c true if the reader skips a malformed object or array and goes on to
+  /// report further errors. Default: \c true.
+  bool recoverFromErrors_;
+
+  /// Maximum nesting depth of objects and arrays; deeper documents are
+  /// rejected. Default: 1000.
+  unsigned int maxDepth_;
 };
 
 } // namespace Json
@@ -375,11 +401,13 @@ public:
 #if !defined(JSON_IS_AMALGAMATION)
 #include "forwards.h"
 #endif // if !defined(JSON_IS_AMALGAMATION)
+#include <cstddef>
 #include <string>
 #include <vector>
 
 #ifndef JSON_USE_CPPTL_SMALLMAP
-#include <map>
+#include <iterator>
+#include <utility>
 #else
 #include <cpptl/smallmap.h>
 #endif
@@ -450,6 +478,93 @@ private:
   const char* str_;
 };
 
+/** \brief Monotonic allocator for the values of a parsed document.
+ *
+ * Pass an Arena to Reader::parse() to take every array, object, member name
+ * and string of the document from a few large blocks instead of allocating
+ * each of them separately. Values stored in an arena are never destroyed one
+ * by one: release() drops the whole document at once and keeps the largest
+ * block for the next one, so the root Value must not be used after it.
+ *
+ * Copying a value out of an arena document yields an ordinary Value that
+ * owns its storage. Documents in an arena are meant to be read; values
+ * swapped into them are not freed when the arena is released.
+ */
+class JSON_API Arena {
+public:
+  explicit Arena(size_t blockSize = 64 * 1024);
+  ~Arena();
+
+  /// Returns size bytes aligned for any Value member.
+  void* allocate(size_t size);
+  /// Returns a zero-terminated copy of the length bytes at value.
+  char* duplicate(const char* value, size_t length);
+  /// Frees everything allocated so far.
+  void release();
+
+private:
+  Arena(const Arena&);
+  Arena& operator=(const Arena&);
+
+  struct Block {
+    Block* next_;
+    size_t size_;
+  };
+  void grow(size_t size);
+
+  Block* blocks_;
+  char* current_;
+  char* end_;
+  size_t nextBlockSize_;
+};
+
+/** \brief Allocator of the containers inside Value, taking memory from an
+ * Arena, or from the heap when no arena is given.
+ *
+ * Copies of a container always use the heap, so that copying a value out of
+ * an arena document yields an independent value.
+ */
+template <typename T> class ArenaAllocator {
+public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  template <typename U> struct rebind { typedef ArenaAllocator<U> other; };
+
+  ArenaAllocator(Arena* arena = 0) : arena_(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+  T* allocate(size_t count) {
+    size_t size = count * sizeof(T);
+    return static_cast<T*>(arena_ ? arena_->allocate(size)
+                                  : ::operator new(size));
+  }
+  void deallocate(T* p, size_t) {
+    if (!arena_)
+      ::operator delete(p);
+  }
+  ArenaAllocator select_on_container_copy_construction() const {
+    return ArenaAllocator();
+  }
+
+  Arena* arena() const { return arena_; }
+
+  template <typename U> bool operator==(const ArenaAllocator<U>& other) const {
+    return arena_ == other.arena();
+  }
+  template <typename U> bool operator!=(const ArenaAllocator<U>& other) const {
+    return arena_ != other.arena();
+  }
+
+private:
+  Arena* arena_;
+};
+
 /** \brief Represents a <a HREF="http://www.json.org">JSON</a> value.
  *
  * This class is a discriminated union wrapper that can represents a:
@@ -536,6 +651,7 @@ private:
     CZString(ArrayIndex index);
     CZString(const char* cstr, DuplicationPolicy allocate);
     CZString(const CZString& other);
+    CZString(CZString&& other) noexcept;
     ~CZString();
     CZString& operator=(CZString other);
     bool operator<(const CZString& other) const;
@@ -552,10 +668,113 @@ private:
 
 public:
 #ifndef JSON_USE_CPPTL_SMALLMAP
-  typedef std::map<CZString, Value> ObjectValues;
+  /** \brief Members of an #objectValue, ordered by name.
+   *
+   * A sorted array of (name hash, member) entries. Members are allocated one
+   * at a time, so references to them stay valid as the object grows; the
+   * iterators, like those of a vector, do not survive an insertion or erase.
+   * Lookups compare the precomputed hashes before any name, and a member
+   * inserted with a static name is found by address when looked up with the
+   * same static name, without comparing strings.
+   */
+  class ObjectValues {
+  public:
+    typedef std::pair<const CZString, Value> value_type;
+    typedef ArenaAllocator<value_type> allocator_type;
+    typedef size_t size_type;
+
+  private:
+    struct Entry {
+      size_t hash_;
+      value_type* member_;
+    };
+    typedef std::vector<Entry, ArenaAllocator<Entry> > Entries;
+
+  public:
+    template <typename Member> class Iterator {
+    public:
+      typedef std::bidirectional_iterator_tag iterator_category;
+      typedef ptrdiff_t difference_type;
+      typedef Member value_type;
+      typedef Member* pointer;
+      typedef Member& reference;
+
+      Iterator() : entry_(0) {}
+      template <typename Other>
+      Iterator(const Iterator<Other>& other) : entry_(other.entry_) {}
+
+      reference operator*() const { return *entry_->member_; }
+      pointer operator->() const { return entry_->member_; }
+      Iterator& operator++() {
+        ++entry_;
+        return *this;
+      }
+      Iterator& operator--() {
+        --entry_;
+        return *this;
+      }
+      difference_type operator-(const Iterator& other) const {
+        return entry_ - other.entry_;
+      }
+      bool operator==(const Iterator& other) const {
+        return entry_ == other.entry_;
+      }
+      bool operator!=(const Iterator& other) const {
+        return entry_ != other.entry_;
+      }
+
+    private:
+      explicit Iterator(const Entry* entry) : entry_(entry) {}
+      const Entry* entry_;
+      friend class ObjectValues;
+      template <typename> friend class Iterator;
+    };
+    typedef Iterator<value_type> iterator;
+    typedef Iterator<const value_type> const_iterator;
+
+    explicit ObjectValues(const allocator_type& allocator = allocator_type());
+    /// Deep copy; the copy is always allocated on the heap.
+    ObjectValues(const ObjectValues& other);
+    ~ObjectValues();
+
+    allocator_type get_allocator() const;
+    size_type size() const { return entries_.size(); }
+    iterator begin() { return iterator(entries_.data()); }
+    iterator end() { return iterator(entries_.data() + entries_.size()); }
+    const_iterator begin() const { return const_iterator(entries_.data()); }
+    const_iterator end() const {
+      return const_iterator(entries_.data() + entries_.size());
+    }
+
+    /// Returns the member named key, or end().
+    iterator find(const char* key);
+    const_iterator find(const char* key) const;
+    /// Returns the value of the member named key, inserting a null member if
+    /// there is none. A static key is stored without being copied.
+    Value& resolve(const char* key, bool isStatic);
+    void erase(iterator position);
+    void clear();
+
+    bool operator==(const ObjectValues& other) const;
+    bool operator<(const ObjectValues& other) const;
+
+  private:
+    ObjectValues& operator=(const ObjectValues&);
+    static size_t hashKey(const char* key);
+    size_t lowerBound(const char* key) const;
+    size_t findIndex(const char* key, size_t hash) const;
+    void destroy(value_type* member);
+
+    Entries entries_;
+  };
 #else
   typedef CppTL::SmallMap<CZString, Value> ObjectValues;
 #endif // ifndef JSON_USE_CPPTL_SMALLMAP
+  /// Elements of an #arrayValue, stored contiguously for O(1) indexing.
+  /// Every index below size() holds an element: assigning past the end
+  /// fills the gap with nulls, which iteration visits and get() returns.
+  /// (When arrays shared the object map, only assigned elements existed.)
+  typedef std::vector<Value, ArenaAllocator<Value> > ArrayValues;
 #endif // ifndef JSON_VALUE_USE_INTERNAL_MAP
 #endif // ifndef JSONCPP_DOC_EXCLUDE_IMPLEMENTATION
 
@@ -601,9 +820,17 @@ Json::Value obj_value(Json::objectValue); // {}
   Value(const CppTL::ConstString& value);
 #endif
   Value(bool value);
+  /// Creates an empty array or object whose elements are allocated from
+  /// arena, or a string copied into arena. See Arena.
+  Value(ValueType type, Arena& arena);
+  Value(const char* beginValue, const char* endValue, Arena& arena);
   Value(const Value& other);
+  /// Takes over other's payload and comments, leaving other null. A value
+  /// moved out of an arena document still lives in the arena.
+  Value(Value&& other) noexcept;
   ~Value();
 
+  /// Copy or move assignment, depending on how other is constructed.
   Value& operator=(Value other);
   /// Swap values.
   /// \note Currently, comments are intentionally not swapped, for
@@ -705,6 +932,7 @@ Json::Value obj_value(Json::objectValue); // {}
   /// If the array contains at least index+1 elements, returns the element
   /// value,
   /// otherwise returns defaultValue.
+  /// An element skipped by assigning past the end is null, not missing.
   Value get(ArrayIndex index, const Value& defaultValue) const;
   /// Return true if index < size().
   bool isValidIndex(ArrayIndex index) const;
@@ -712,6 +940,7 @@ Json::Value obj_value(Json::objectValue); // {}
   ///
   /// Equivalent to jsonvalue[jsonvalue.size()] = value;
   Value& append(const Value& value);
+  Value& append(Value&& value);
 
   /// Access an object value by name, create a null member if it does not exist.
   Value& operator[](const char* key);
@@ -792,6 +1021,8 @@ Json::Value obj_value(Json::objectValue); // {}
 
   std::string toStyledString() const;
 
+  /// On an array, iteration visits every index below size(), including the
+  /// nulls left by assigning past the end.
   const_iterator begin() const;
   const_iterator end() const;
 
@@ -807,6 +1038,9 @@ Json::Value obj_value(Json::objectValue); // {}
 
 private:
   Value& resolveReference(const char* key, bool isStatic);
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+  void resizeArray(ArrayIndex newSize);
+#endif
 
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
   inline bool isItemAvailable() const { return itemIsUsed_ == 0; }
@@ -849,10 +1083,13 @@ private:
     ValueInternalArray* array_;
     ValueInternalMap* map_;
 #else
+    ArrayValues* array_;
     ObjectValues* map_;
 #endif
   } value_;
   ValueType type_ : 8;
+  // The string, array or object payload is owned by this value (as opposed
+  // to a static string or a payload living in an Arena).
   int allocated_ : 1; // Notes: if declared as bool, bitfield is useless.
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
   unsigned int itemIsUsed_ : 1; // used by the ValueInternalMap container.
@@ -1281,6 +1518,8 @@ public:
   ValueIteratorBase();
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   explicit ValueIteratorBase(const Value::ObjectValues::iterator& current);
+  ValueIteratorBase(const Value::ArrayValues::iterator& begin,
+                    const Value::ArrayValues::iterator& current);
 #else
   ValueIteratorBase(const ValueInternalArray::IteratorState& state);
   ValueIteratorBase(const ValueInternalMap::IteratorState& state);
@@ -1321,8 +1560,13 @@ protected:
 private:
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   Value::ObjectValues::iterator current_;
+  // Used instead of current_ when iterating over an arrayValue; arrayBegin_
+  // gives the index of the referenced element.
+  Value::ArrayValues::iterator arrayBegin_;
+  Value::ArrayValues::iterator arrayCurrent_;
   // Indicates that iterator is for a null value.
   bool isNull_;
+  bool isArray_;
 #else
   union {
     ValueInternalArray::IteratorState array_;
@@ -1353,6 +1597,8 @@ private:
  */
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   explicit ValueConstIterator(const Value::ObjectValues::iterator& current);
+  ValueConstIterator(const Value::ArrayValues::iterator& begin,
+                     const Value::ArrayValues::iterator& current);
 #else
   ValueConstIterator(const ValueInternalArray::IteratorState& state);
   ValueConstIterator(const ValueInternalMap::IteratorState& state);
@@ -1409,6 +1655,8 @@ private:
  */
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   explicit ValueIterator(const Value::ObjectValues::iterator& current);
+  ValueIterator(const Value::ArrayValues::iterator& begin,
+                const Value::ArrayValues::iterator& current);
 #else
   ValueIterator(const ValueInternalArray::IteratorState& state);
   ValueIterator(const ValueInternalMap::IteratorState& state);
@@ -1478,7 +1726,7 @@ public:
 #endif // if !defined(JSON_IS_AMALGAMATION)
 #include <deque>
 #include <iosfwd>
-#include <stack>
+#include <vector>
 #include <string>
 
 // Disable warning C4251: <data member>: <type> needs to have dll-interface to
@@ -1565,6 +1813,30 @@ public:
   /// \see Json::operator>>(std::istream&, Json::Value&).
   bool parse(std::istream& is, Value& root, bool collectComments = true);
 
+  /** \brief Read a Value from a document, allocating it from arena.
+   *
+   * The document is parsed without comments. root is only valid until
+   * arena.release().
+   */
+  bool parse(const std::string& document, Value& root, Arena& arena);
+  bool parse(const char* beginDoc,
+             const char* endDoc,
+             Value& root,
+             Arena& arena);
+
+  /** \brief Index a document for reading on demand, without decoding it.
+   *
+   * The text is referenced, not copied: it must stay alive and unchanged
+   * while values of document are read. Comments are skipped, and parsing
+   * stops at the first error. Numbers and strings are only scanned for their
+   * end, so a document that the Value overloads reject only for a malformed
+   * number or string (a bad escape sequence, a lone surrogate) is accepted
+   * here; that value converts as null when it is read.
+   * \sa LazyDocument
+   */
+  bool parse(const char* beginDoc, const char* endDoc, LazyDocument& document);
+  bool parse(const std::string& text, LazyDocument& document);
+
   /** \brief Returns a user friendly string that list errors in the parsed
    * document.
    * \return Formatted error message with the list of errors with their location
@@ -1630,6 +1902,20 @@ private:
 
   typedef std::deque<ErrorInfo> Errors;
 
+  /// An object or array whose members are still being read.
+  class Frame {
+  public:
+    Value* value_;
+    Location start_;
+    ArrayIndex index_;
+    bool isObject_;
+    /// \c true once a member has been read into value_.
+    bool hasMember_;
+    bool lastNameEmpty_;
+  };
+
+  typedef std::vector<Frame> Frames;
+
   bool expectToken(TokenType type, Token& token, const char* message);
   bool readToken(Token& token);
   void skipSpaces();
@@ -1640,8 +1926,10 @@ private:
   bool readString();
   void readNumber();
   bool readValue();
-  bool readObject(Token& token);
-  bool readArray(Token& token);
+  bool beginValue();
+  bool readObjectMember(Frame& frame, bool& successful);
+  bool readArrayElement(Frame& frame, bool& successful);
+  bool readLazyValue(LazyDocument& document);
   bool decodeNumber(Token& token);
   bool decodeNumber(Token& token, Value& decoded);
   bool decodeString(Token& token);
@@ -1669,9 +1957,14 @@ private:
   std::string getLocationLineAndColumn(Location location) const;
   void addComment(Location begin, Location end, CommentPlacement placement);
   void skipCommentTokens(Token& token);
-
-  typedef std::stack<Value*> Nodes;
-  Nodes nodes_;
+  void setCurrentOffsets(Location start, Location limit);
+
+  /// Open containers, innermost last; grown as deeper documents are read,
+  /// up to Features::maxDepth_.
+  Frames frames_;
+  size_t depth_;
+  /// The value being read.
+  Value* node_;
   Errors errors_;
   std::string document_;
   Location begin_;
@@ -1680,8 +1973,134 @@ private:
   Location lastValueEnd_;
   Value* lastValue_;
   std::string commentsBefore_;
+  /// Reused by decodeString() so that decoding does not allocate.
+  std::string stringBuffer_;
+  Arena* arena_;
   Features features_;
   bool collectComments_;
+
+  friend class LazyDocument;
+};
+
+/** \brief A read-only handle on a value of a LazyDocument.
+ *
+ * Containers are walked through the document's index. Numbers and strings
+ * are decoded from the source text each time they are read, so keep the
+ * result of a conversion that is needed repeatedly. A missing member or
+ * index gives a null LazyValue, as the const accessors of Value do. Handles
+ * are invalidated when their document is parsed again.
+ */
+class JSON_API LazyValue {
+public:
+  /// A null value that belongs to no document.
+  LazyValue();
+
+  /// Decodes numbers to tell intValue, uintValue and realValue apart.
+  ValueType type() const;
+  bool isNull() const;
+  bool isBool() const;
+  bool isNumeric() const;
+  bool isString() const;
+  bool isArray() const;
+  bool isObject() const;
+
+  /// Number of elements of an array or members of an object, 0 otherwise.
+  /// Members with the same name count once, as in decode(); counting them
+  /// decodes the names of an object with more than one member.
+  ArrayIndex size() const;
+
+  LazyValue operator[](ArrayIndex index) const;
+  LazyValue operator[](int index) const;
+  /// If an object has several members named key, the last one is returned,
+  /// as it is the one Reader keeps.
+  LazyValue operator[](const char* key) const;
+  LazyValue operator[](const std::string& key) const;
+  bool isMember(const char* key) const;
+  /// Member names of an object, each once, in the document order of the
+  /// members that decode() keeps (the last of each name).
+  Value::Members getMemberNames() const;
+
+  /// Conversions behave as they do on the Value that decode() returns.
+  Value::Int asInt() const;
+  Value::UInt asUInt() const;
+  Value::LargestInt asLargestInt() const;
+  Value::LargestUInt asLargestUInt() const;
+  double asDouble() const;
+  bool asBool() const;
+  std::string asString() const;
+
+  /** \brief Points begin and end at the characters of a string without
+   * escape sequences, in the source text, and returns true. Returns false
+   * for any other value.
+   */
+  bool getRawString(const char*& begin, const char*& end) const;
+
+  /// Decodes this value and everything it contains.
+  Value decode() const;
+
+private:
+  LazyValue(const LazyDocument* document, unsigned node);
+  /// The type recorded by the index, without decoding numbers.
+  ValueType indexedType() const;
+  Value decodeScalar() const;
+
+  const LazyDocument* document_;
+  unsigned node_;
+
+  friend class LazyDocument;
+};
+
+/** \brief The structural index of a JSON text, filled by
+ * Reader::parse(const char*, const char*, LazyDocument&).
+ *
+ * The index records where each value starts and ends and which values each
+ * container holds. Nothing is decoded and no Value is built until it is read
+ * through root(), so a large string that is never read costs only the scan
+ * for its closing quote. Reading decodes through a Reader that belongs to
+ * the document, so a document must not be read from several threads at once.
+ */
+class JSON_API LazyDocument {
+public:
+  LazyDocument();
+
+  /// The root value, or null if the last parse failed.
+  LazyValue root() const;
+
+private:
+  /// A value of the text. Containers list their elements, or the names of
+  /// their members, in children_; a member's value is the node after its
+  /// name.
+  struct Node {
+    /// The token, quotes included; a container ends after its closing bracket.
+    const char* start_;
+    const char* end_;
+    /// First entry in children_ and number of entries, for containers.
+    unsigned children_;
+    unsigned size_;
+    /// realValue stands for any number until it is decoded.
+    ValueType type_;
+  };
+
+  /// A container whose members are still being read.
+  struct Frame {
+    unsigned node_;
+    /// Where its members start in pending_.
+    unsigned pending_;
+    bool hasMember_;
+  };
+
+  bool decodeScalar(unsigned node, Value& decoded) const;
+  bool decodeString(unsigned node, std::string& decoded) const;
+
+  std::vector<Node> nodes_;
+  std::vector<unsigned> children_;
+  /// Members of the open containers, moved to children_ as each one closes.
+  std::vector<unsigned> pending_;
+  std::vector<Frame> open_;
+  mutable Reader decoder_;
+
+  friend class Reader;
+  friend class LazyValue;
 };
 
 /** \brief Read from 'sin' into 'root'.
@@ -1756,6 +2175,61 @@ namespace Json {
 
 class Value;
 
+/** \brief Destination of a streaming write: a caller supplied string, or a
+ * file descriptor fed through a fixed size buffer.
+ *
+ * Writing to a string appends to it in place, so a caller that keeps the
+ * string between documents reuses its capacity. Writing to a file descriptor
+ * passes the output on whenever capacity bytes are buffered, and on flush()
+ * or destruction; a document of any size needs no more memory than that.
+ * \sa Writer::write(OutputBuffer&, const Value&)
+ */
+class JSON_API OutputBuffer {
+public:
+  /// Appends to document, after what it already contains.
+  explicit OutputBuffer(std::string& document);
+  /// Writes to the file descriptor fd, e.g. 1 for the standard output.
+  /// A negative fd makes every flush() fail.
+  explicit OutputBuffer(int fd, size_t capacity = 64 * 1024);
+  ~OutputBuffer();
+
+  void write(const char* data, size_t length) {
+    output_->append(data, length);
+    if (output_->size() >= capacity_)
+      flush();
+  }
+  void write(const std::string& text) { write(text.data(), text.size()); }
+  void write(char c) {
+    *output_ += c;
+    if (output_->size() >= capacity_)
+      flush();
+  }
+
+  /// Returns the last character written, or 0 if nothing has been.
+  char last() const {
+    return output_->empty() ? last_ : (*output_)[output_->size() - 1];
+  }
+
+  /** \brief Passes the buffered output on to the file descriptor.
+   * \return false if this or an earlier write to the file descriptor failed.
+   *         Output written after a failure is discarded.
+   */
+  bool flush();
+
+private:
+  OutputBuffer(const OutputBuffer&);
+  OutputBuffer& operator=(const OutputBuffer&);
+
+  std::string buffer_;
+  std::string* output_;
+  size_t capacity_;
+  int fd_;
+  char last_;
+  /// Appending to a caller's string, which is never flushed.
+  bool toDocument_;
+  bool failed_;
+};
+
 /** \brief Abstract class for writers.
  */
 class JSON_API Writer {
@@ -1763,6 +2237,12 @@ public:
   virtual ~Writer();
 
   virtual std::string write(const Value& root) = 0;
+
+  /** \brief Serialize root into out as it goes, without building the whole
+   * document as a string first. The default implementation writes the
+   * result of write(root).
+   */
+  virtual void write(OutputBuffer& out, const Value& root);
 };
 
 /** \brief Outputs a Value in <a HREF="http://www.json.org">JSON</a> format
@@ -1791,11 +2271,13 @@ public:
 
 public: // overridden from Writer
   virtual std::string write(const Value& root);
+  virtual void write(OutputBuffer& out, const Value& root);
 
 private:
   void writeValue(const Value& value);
 
   std::string document_;
+  OutputBuffer* out_;
   bool yamlCompatiblityEnabled_;
   bool dropNullPlaceholders_;
   bool omitEndingLineFeed_;
@@ -1835,14 +2317,21 @@ public: // overridden from Writer
    * \return String containing the JSON document that represents the root value.
    */
   virtual std::string write(const Value& root);
+  virtual void write(OutputBuffer& out, const Value& root);
 
 private:
   void writeValue(const Value& value);
   void writeArrayValue(const Value& value);
   bool isMultineArray(const Value& value);
-  void pushValue(const std::string& value);
+  void pushValue(const char* value, size_t length);
+  void pushValue(const std::string& value) {
+    pushValue(value.data(), value.size());
+  }
   void writeIndent();
-  void writeWithIndent(const std::string& value);
+  void writeWithIndent(const char* value, size_t length);
+  void writeWithIndent(const std::string& value) {
+    writeWithIndent(value.data(), value.size());
+  }
   void indent();
   void unindent();
   void writeCommentBeforeValue(const Value& root);
@@ -1850,11 +2339,13 @@ private:
   bool hasCommentForValue(const Value& value);
   static std::string normalizeEOL(const std::string& text);
 
-  typedef std::vector<std::string> ChildValues;
-
-  ChildValues childValues_;
+  /// Single line array elements, formatted one after another in childValues_;
+  /// element i ends at childEnds_[i].
+  std::string childValues_;
+  std::vector<size_t> childEnds_;
   std::string document_;
-  std::string indentString_;
+  OutputBuffer* out_;
+  int indentation_;
   int rightMargin_;
   int indentSize_;
   bool addChildValues_;
@@ -4,6 +4,27 @@
 #include <iostream>
 #include <ctime>
 #include <cstring>
+#include <climits>
+#include <cstdio>
+#include <vector>
+#include <memory>
+#include <chrono>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#ifndef _MSC_VER
+#include <unistd.h>
+#ifndef _BOTZONE_ONLINE
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#endif
 #include "jsoncpp/json.h"
 
 using std::cin;
@@ -18,6 +39,7 @@ namespace TankGame
 using std::istream;
 using std::set;
 using std::stack;
+using std::vector;
 
 #ifdef _MSC_VER
 #pragma region 常量定义和说明
@@ -141,6 +163,102 @@ inline int ExtractDirectionFromAction(Action x)
 	return -1;
 }
 
+// x 中为 1 的位数
+inline int PopCount(unsigned int x)
+{
+#ifdef _MSC_VER
+	return (int)__popcnt(x);
+#else
+	return __builtin_popcount(x);
+#endif
+}
+
+// x 中最低的为 1 的位的编号，x 不能为 0
+inline int LowestBit(unsigned int x)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, x);
+	return (int)index;
+#else
+	return __builtin_ctz(x);
+#endif
+}
+
+// splitmix64，用于从一个种子展开出随机数发生器的状态
+inline unsigned long long SplitMix64(unsigned long long &state)
+{
+	unsigned long long z = (state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+// xoshiro256** 随机数发生器，比 rand() 快，没有全局锁，并且相同的种子在任何平台上都得到相同的序列
+class Random
+{
+  public:
+	explicit Random(unsigned long long seed = 1)
+	{
+		Seed(seed);
+	}
+
+	void Seed(unsigned long long seed)
+	{
+		for (int i = 0; i < 4; i++)
+			state[i] = SplitMix64(seed);
+	}
+
+	// 读取和恢复内部状态，用于把发生器存进存档
+	void GetState(unsigned long long out[4]) const
+	{
+		for (int i = 0; i < 4; i++)
+			out[i] = state[i];
+	}
+
+	void SetState(const unsigned long long in[4])
+	{
+		for (int i = 0; i < 4; i++)
+			state[i] = in[i];
+	}
+
+	unsigned long long Next()
+	{
+		unsigned long long result = _rotateLeft(state[1] * 5, 7) * 9, t = state[1] << 17;
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+		state[2] ^= t;
+		state[3] = _rotateLeft(state[3], 45);
+		return result;
+	}
+
+	// [0, n) 中均匀分布的整数（n > 0），用乘法代替取模，只在极少数情况下需要重新取数来消除偏差
+	unsigned int Uniform(unsigned int n)
+	{
+		unsigned long long m = (Next() >> 32) * n;
+		if ((unsigned int)m < n)
+		{
+			unsigned int threshold = (0U - n) % n;
+			while ((unsigned int)m < threshold)
+				m = (Next() >> 32) * n;
+		}
+		return (unsigned int)(m >> 32);
+	}
+
+  private:
+	unsigned long long state[4];
+
+	static unsigned long long _rotateLeft(unsigned long long x, int k)
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+};
+
+// 每个线程一个随机数发生器，默认种子固定，需要不同的序列时用 Seed 指定
+thread_local Random threadRandom;
+
 // 物件消失的记录，用于回退
 struct DisappearLog
 {
@@ -208,7 +326,7 @@ class TankField
 
 	// 判断行为是否合法（出界或移动到非空格子算作非法）
 	// 未考虑坦克是否存活
-	bool ActionIsValid(int side, int tank, Action act)
+	bool ActionIsValid(int side, int tank, Action act) const
 	{
 		if (act == Invalid)
 			return false;
@@ -221,9 +339,36 @@ class TankField
 		return CoordValid(x, y) && gameField[y][x] == None;
 	}
 
+	// 所有合法行为的集合，第 act - Stay 位表示 act 是否合法，已炸的坦克只能 Stay
+	unsigned int LegalMask(int side, int tank) const
+	{
+		const unsigned int stay = 1U, shoots = 0xFU << (UpShoot - Stay);
+		if (!tankAlive[side][tank])
+			return stay;
+		unsigned int mask = stay;
+		if (previousActions[currentTurn - 1][side][tank] <= Left)
+			mask |= shoots;
+		for (int dir = Up; dir <= Left; dir++)
+		{
+			int x = tankX[side][tank] + dx[dir], y = tankY[side][tank] + dy[dir];
+			if (CoordValid(x, y) && gameField[y][x] == None)
+				mask |= 1U << (dir - Stay);
+		}
+		return mask;
+	}
+
+	// 用当前线程的随机数发生器在合法行为中均匀地选一个
+	Action SampleLegal(int side, int tank) const
+	{
+		unsigned int mask = LegalMask(side, tank);
+		for (unsigned int k = threadRandom.Uniform(PopCount(mask)); k; k--)
+			mask &= mask - 1;
+		return (Action)(LowestBit(mask) + Stay);
+	}
+
 	// 判断 nextAction 中的所有行为是否都合法
 	// 忽略掉未存活的坦克
-	bool ActionIsValid()
+	bool ActionIsValid() const
 	{
 		for (int side = 0; side < sideCount; side++)
 			for (int tank = 0; tank < tankPerSide; tank++)
@@ -251,6 +396,43 @@ class TankField
 		gameField[currY][currX] |= tankItemTypes[side][tank];
 	}
 
+	// 找到 side 方 tank 号坦克本回合射击命中的格子
+	// 射出场地或者与对方对射抵消时返回 false
+	bool _findShotTarget(int side, int tank, int &x, int &y)
+	{
+		Action act = nextAction[side][tank];
+		int dir = ExtractDirectionFromAction(act);
+		x = tankX[side][tank];
+		y = tankY[side][tank];
+		bool hasMultipleTankWithMe = HasMultipleTank(gameField[y][x]);
+		while (true)
+		{
+			x += dx[dir];
+			y += dy[dir];
+			if (!CoordValid(x, y))
+				return false;
+			FieldItem items = gameField[y][x];
+			if (items != None)
+			{
+				// 对射判断
+				if (items >= Blue0 &&
+					!hasMultipleTankWithMe && !HasMultipleTank(items))
+				{
+					// 自己这里和射到的目标格子都只有一个坦克
+					Action theirAction = nextAction[GetTankSide(items)][GetTankID(items)];
+					if (ActionIsShoot(theirAction) &&
+						ActionDirectionIsOpposite(act, theirAction))
+					{
+						// 而且我方和对方的射击方向是反的
+						// 那么就忽视这次射击
+						return false;
+					}
+				}
+				return true;
+			}
+		}
+	}
+
   public:
 	// 执行 nextAction 中指定的行为并进入下一回合，返回行为是否合法
 	bool DoAction()
@@ -294,50 +476,22 @@ class TankField
 		for (int side = 0; side < sideCount; side++)
 			for (int tank = 0; tank < tankPerSide; tank++)
 			{
-				Action act = nextAction[side][tank];
-				if (tankAlive[side][tank] && ActionIsShoot(act))
+				int x, y;
+				if (tankAlive[side][tank] && ActionIsShoot(nextAction[side][tank]) &&
+					_findShotTarget(side, tank, x, y))
 				{
-					int dir = ExtractDirectionFromAction(act);
-					int x = tankX[side][tank], y = tankY[side][tank];
-					bool hasMultipleTankWithMe = HasMultipleTank(gameField[y][x]);
-					while (true)
-					{
-						x += dx[dir];
-						y += dy[dir];
-						if (!CoordValid(x, y))
-							break;
-						FieldItem items = gameField[y][x];
-						if (items != None)
+					// 标记这些物件要被摧毁了（防止重复摧毁）
+					FieldItem items = gameField[y][x];
+					for (int mask = 1; mask <= Red1; mask <<= 1)
+						if (items & mask)
 						{
-							// 对射判断
-							if (items >= Blue0 &&
-								!hasMultipleTankWithMe && !HasMultipleTank(items))
-							{
-								// 自己这里和射到的目标格子都只有一个坦克
-								Action theirAction = nextAction[GetTankSide(items)][GetTankID(items)];
-								if (ActionIsShoot(theirAction) &&
-									ActionDirectionIsOpposite(act, theirAction))
-								{
-									// 而且我方和对方的射击方向是反的
-									// 那么就忽视这次射击
-									break;
-								}
-							}
-
-							// 标记这些物件要被摧毁了（防止重复摧毁）
-							for (int mask = 1; mask <= Red1; mask <<= 1)
-								if (items & mask)
-								{
-									DisappearLog log;
-									log.x = x;
-									log.y = y;
-									log.item = (FieldItem)mask;
-									log.turn = currentTurn;
-									itemsToBeDestroyed.insert(log);
-								}
-							break;
+							DisappearLog log;
+							log.x = x;
+							log.y = y;
+							log.item = (FieldItem)mask;
+							log.turn = currentTurn;
+							itemsToBeDestroyed.insert(log);
 						}
-					}
 				}
 			}
 
@@ -379,6 +533,71 @@ class TankField
 		return true;
 	}
 
+	// 与 DoAction 的效果相同，但不记录 log，也不为去重分配内存，用于快速回放历史
+	// 之后不能 Revert 到这些回合之前
+	bool FastForward()
+	{
+		if (!ActionIsValid())
+			return false;
+
+		// 1 移动
+		for (int side = 0; side < sideCount; side++)
+			for (int tank = 0; tank < tankPerSide; tank++)
+			{
+				Action act = nextAction[side][tank];
+				previousActions[currentTurn][side][tank] = act;
+				if (tankAlive[side][tank] && ActionIsMove(act))
+				{
+					int &x = tankX[side][tank], &y = tankY[side][tank];
+					gameField[y][x] &= ~tankItemTypes[side][tank];
+					x += dx[act];
+					y += dy[act];
+					gameField[y][x] |= tankItemTypes[side][tank];
+				}
+			}
+
+		// 2 射击，每个坦克至多命中一个格子，同一格子被多次命中时只记一次
+		int targetCount = 0, targetX[sideCount * tankPerSide], targetY[sideCount * tankPerSide];
+		for (int side = 0; side < sideCount; side++)
+			for (int tank = 0; tank < tankPerSide; tank++)
+			{
+				int x, y, i;
+				if (tankAlive[side][tank] && ActionIsShoot(nextAction[side][tank]) &&
+					_findShotTarget(side, tank, x, y))
+				{
+					for (i = 0; i < targetCount; i++)
+						if (targetX[i] == x && targetY[i] == y)
+							break;
+					if (i == targetCount)
+					{
+						targetX[targetCount] = x;
+						targetY[targetCount++] = y;
+					}
+				}
+			}
+
+		for (int i = 0; i < targetCount; i++)
+		{
+			int x = targetX[i], y = targetY[i];
+			FieldItem items = gameField[y][x];
+			if (items & Base)
+				baseAlive[y == baseY[Blue] && x == baseX[Blue] ? Blue : Red] = false;
+			for (int side = 0; side < sideCount; side++)
+				for (int tank = 0; tank < tankPerSide; tank++)
+					if (items & tankItemTypes[side][tank])
+						_destroyTank(side, tank);
+			// 钢墙不会被摧毁
+			gameField[y][x] = items & Steel;
+		}
+
+		for (int side = 0; side < sideCount; side++)
+			for (int tank = 0; tank < tankPerSide; tank++)
+				nextAction[side][tank] = Invalid;
+
+		currentTurn++;
+		return true;
+	}
+
 	// 回到上一回合
 	bool Revert()
 	{
@@ -426,7 +645,7 @@ class TankField
 	}
 
 	// 游戏是否结束？谁赢了？
-	GameResult GetGameResult()
+	GameResult GetGameResult() const
 	{
 		bool fail[sideCount] = {};
 		for (int side = 0; side < sideCount; side++)
@@ -464,6 +683,69 @@ class TankField
 		gameField[baseY[0] + 1][baseX[0]] = gameField[baseY[1] - 1][baseX[1]] = Steel;
 	}
 
+	// 把局面写成紧凑的二进制追加到 out 末尾
+	// 不包含 logs，因此恢复出来的局面不能 Revert 到恢复之前的回合
+	void SaveSnapshot(string &out) const
+	{
+		out += (char)mySide;
+		out += (char)currentTurn;
+		for (int y = 0; y < fieldHeight; y++)
+			for (int x = 0; x < fieldWidth; x++)
+				out += (char)gameField[y][x];
+		int aliveBits = 0;
+		for (int side = 0; side < sideCount; side++)
+		{
+			for (int tank = 0; tank < tankPerSide; tank++)
+			{
+				aliveBits |= tankAlive[side][tank] << (side * tankPerSide + tank);
+				out += (char)tankX[side][tank];
+				out += (char)tankY[side][tank];
+			}
+			aliveBits |= baseAlive[side] << (sideCount * tankPerSide + side);
+		}
+		out += (char)aliveBits;
+		// 每个动作 +2 后占 4 位，一回合四个动作共两个字节
+		for (int turn = 1; turn < currentTurn; turn++)
+			for (int side = 0; side < sideCount; side++)
+				out += (char)((previousActions[turn][side][0] + 2) | (previousActions[turn][side][1] + 2) << 4);
+	}
+
+	// 从 SaveSnapshot 的结果恢复局面，成功时 p 移动到已读内容之后
+	bool LoadSnapshot(const unsigned char *&p, const unsigned char *end)
+	{
+		const int headerSize = 2 + fieldHeight * fieldWidth + sideCount * tankPerSide * 2 + 1;
+		if (end - p < headerSize || p[0] >= sideCount || p[1] < 1 || p[1] > 101 ||
+			end - p < headerSize + (p[1] - 1) * sideCount)
+			return false;
+		mySide = *p++;
+		currentTurn = *p++;
+		for (int y = 0; y < fieldHeight; y++)
+			for (int x = 0; x < fieldWidth; x++)
+				gameField[y][x] = (FieldItem)*p++;
+		for (int side = 0; side < sideCount; side++)
+			for (int tank = 0; tank < tankPerSide; tank++)
+			{
+				tankX[side][tank] = (signed char)*p++;
+				tankY[side][tank] = (signed char)*p++;
+			}
+		int aliveBits = *p++;
+		for (int side = 0; side < sideCount; side++)
+		{
+			for (int tank = 0; tank < tankPerSide; tank++)
+				tankAlive[side][tank] = aliveBits >> (side * tankPerSide + tank) & 1;
+			baseAlive[side] = aliveBits >> (sideCount * tankPerSide + side) & 1;
+		}
+		for (int turn = 1; turn < currentTurn; turn++)
+			for (int side = 0; side < sideCount; side++, p++)
+			{
+				previousActions[turn][side][0] = (Action)((*p & 15) - 2);
+				previousActions[turn][side][1] = (Action)((*p >> 4) - 2);
+			}
+		while (!logs.empty())
+			logs.pop();
+		return true;
+	}
+
 	// 打印场地
 	void DebugPrint()
 	{
@@ -539,677 +821,2423 @@ class TankField
 #pragma endregion
 #endif
 
-TankField *field;
-
+// 批量模拟只在本地工具中使用（由 tools/perft.cpp 的 -batch 与 TankField 对照），不编译进提交的 bot
+#ifdef TANKGAME_NO_MAIN
 #ifdef _MSC_VER
-#pragma region 与平台交互部分
+#pragma region BatchField 批量模拟
 #endif
 
-// 内部函数
-namespace Internals
+// 同时模拟多局互不相关的游戏，用于大量随机对局（rollout）
+// 每局的状态按字段分开存放（structure of arrays），砖块和钢墙用两个 64 位整数组成的位棋盘表示，
+// 格子编号为 y * fieldWidth + x，编号 0~63 在 Lo 中，64~80 在 Hi 中
+// StepAll 的效果与对每一局分别调用 TankField::DoAction 完全相同；编译时开启 AVX2 则每次同时处理 4 局
+class BatchField
 {
-Json::Reader reader;
-#ifdef _BOTZONE_ONLINE
-Json::FastWriter writer;
-#else
-Json::StyledWriter writer;
-#endif
+  public:
+	// 对局数
+	int gameCount;
 
-void _processRequestOrResponse(Json::Value &value, bool isOpponent)
-{
-	if (value.isArray())
+	// 砖块和钢墙的位棋盘
+	vector<unsigned long long> brickLo, brickHi, steelLo, steelHi;
+
+	// 坦克所在格子的编号，-1 表示坦克已炸
+	vector<long long> tankPos[sideCount][tankPerSide];
+
+	// 按位记录坦克是否存活、上回合是否射击（都是第 side * tankPerSide + tank 位），以及基地是否存活（第 side 位）
+	vector<int> tankAlive, lastShoot, baseAlive;
+
+	// 当前回合编号
+	vector<int> currentTurn;
+
+	explicit BatchField(int gameCount)
+		: gameCount(gameCount), brickLo(gameCount), brickHi(gameCount), steelLo(gameCount), steelHi(gameCount),
+		  tankAlive(gameCount), lastShoot(gameCount), baseAlive(gameCount), currentTurn(gameCount)
 	{
-		if (!isOpponent)
-		{
+		for (int side = 0; side < sideCount; side++)
 			for (int tank = 0; tank < tankPerSide; tank++)
-				field->nextAction[field->mySide][tank] = (Action)value[tank].asInt();
-		}
-		else
+				tankPos[side][tank].resize(gameCount);
+	}
+
+	// 把第 game 局设为新的一局，场地的格式与 TankField 的构造函数相同
+	void Reset(int game, int hasBrick[3])
+	{
+		Load(game, TankField(hasBrick, Blue));
+	}
+
+	// 把第 game 局设为 field 的局面
+	void Load(int game, const TankField &field)
+	{
+		brickLo[game] = brickHi[game] = steelLo[game] = steelHi[game] = 0;
+		for (int y = 0; y < fieldHeight; y++)
+			for (int x = 0; x < fieldWidth; x++)
+			{
+				if (field.gameField[y][x] & Brick)
+					_setBit(brickLo[game], brickHi[game], y * fieldWidth + x);
+				if (field.gameField[y][x] & Steel)
+					_setBit(steelLo[game], steelHi[game], y * fieldWidth + x);
+			}
+		tankAlive[game] = lastShoot[game] = baseAlive[game] = 0;
+		for (int side = 0; side < sideCount; side++)
 		{
 			for (int tank = 0; tank < tankPerSide; tank++)
-				field->nextAction[1 - field->mySide][tank] = (Action)value[tank].asInt();
-			field->DoAction();
+			{
+				int bit = 1 << (side * tankPerSide + tank);
+				if (field.tankAlive[side][tank])
+				{
+					tankAlive[game] |= bit;
+					tankPos[side][tank][game] = field.tankY[side][tank] * fieldWidth + field.tankX[side][tank];
+				}
+				else
+					tankPos[side][tank][game] = -1;
+				if (ActionIsShoot(field.previousActions[field.currentTurn - 1][side][tank]))
+					lastShoot[game] |= bit;
+			}
+			if (field.baseAlive[side])
+				baseAlive[game] |= 1 << side;
 		}
+		currentTurn[game] = field.currentTurn;
 	}
-	else
+
+	// 第 game 局 (x, y) 格子上的物件，与 TankField::gameField 相同
+	FieldItem GetItems(int game, int x, int y) const
 	{
-		// 是第一回合，裁判在介绍场地
-		int hasBrick[3];
-		for (int i = 0; i < 3; i++)
-			hasBrick[i] = value["field"][i].asInt();
-		field = new TankField(hasBrick, value["mySide"].asInt());
+		int cell = y * fieldWidth + x;
+		FieldItem items = None;
+		if (_testBit(brickLo[game], brickHi[game], cell))
+			items |= Brick;
+		if (_testBit(steelLo[game], steelHi[game], cell))
+			items |= Steel;
+		for (int side = 0; side < sideCount; side++)
+		{
+			if (baseAlive[game] >> side & 1 && cell == _baseCell(side))
+				items |= Base;
+			for (int tank = 0; tank < tankPerSide; tank++)
+				if (tankPos[side][tank][game] == cell)
+					items |= tankItemTypes[side][tank];
+		}
+		return items;
 	}
-}
-
-// 请使用 SubmitAndExit 或者 SubmitAndDontExit
-void _submitAction(Action tank0, Action tank1, string debug = "", string data = "", string globalData = "")
-{
-	Json::Value output(Json::objectValue), response(Json::arrayValue);
-	response[0U] = tank0;
-	response[1U] = tank1;
-	output["response"] = response;
-	if (!debug.empty())
-		output["debug"] = debug;
-	if (!data.empty())
-		output["data"] = data;
-	if (!globalData.empty())
-		output["globalData"] = globalData;
-	cout << writer.write(output) << endl;
-}
-} // namespace Internals
 
-// 从输入流（例如 cin 或者 fstream）读取回合信息，存入 TankField，并提取上回合存储的 data 和 globaldata
-// 本地调试的时候支持多行，但是最后一行需要以没有缩进的一个"}"或"]"结尾
-void ReadInput(istream &in, string &outData, string &outGlobalData)
-{
-	Json::Value input;
-	string inputString;
-	do
-	{
-		getline(in, inputString);
-	} while (inputString.empty());
-#ifndef _BOTZONE_ONLINE
-	// 猜测是单行还是多行
-	char lastChar = inputString[inputString.size() - 1];
-	if (lastChar != '}' && lastChar != ']')
+	// 判断第 game 局中的行为是否合法，与 TankField::ActionIsValid 相同，未考虑坦克是否存活
+	bool ActionIsValid(int game, int side, int tank, Action act) const
 	{
-		// 第一行不以}或]结尾，猜测是多行
-		string newString;
-		do
-		{
-			getline(in, newString);
-			inputString += newString;
-		} while (newString != "}" && newString != "]");
+		if (act == Invalid)
+			return false;
+		if (act > Left && lastShoot[game] >> (side * tankPerSide + tank) & 1) // 连续两回合射击
+			return false;
+		if (act == Stay || act > Left)
+			return true;
+		int pos = (int)tankPos[side][tank][game];
+		int x = pos % fieldWidth + dx[act], y = pos / fieldWidth + dy[act];
+		return CoordValid(x, y) && GetItems(game, x, y) == None;
 	}
-#endif
-	Internals::reader.parse(inputString, input);
 
-	if (input.isObject())
+	// 每一局同时执行 actions[game] 中指定的行为并进入下一回合
+	// 如果某一局有存活坦克的行为不合法，这一局保持不变；applied 不为空时记录每一局是否执行了
+	void StepAll(const Action (*actions)[sideCount][tankPerSide], bool *applied = nullptr)
 	{
-		Json::Value requests = input["requests"], responses = input["responses"];
-		if (!requests.isNull() && requests.isArray())
+		int game = 0;
+#ifdef __AVX2__
+		for (; game + 4 <= gameCount; game += 4)
+			_stepAVX2(game, actions, applied);
+#endif
+		for (; game < gameCount; game++)
 		{
-			size_t i, n = requests.size();
-			for (i = 0; i < n; i++)
-			{
-				Internals::_processRequestOrResponse(requests[(int)i], true);
-				if (i < n - 1)
-					Internals::_processRequestOrResponse(responses[(int)i], false);
-			}
-			outData = input["data"].asString();
-			outGlobalData = input["globaldata"].asString();
-			return;
+			bool stepped = _step(game, actions[game]);
+			if (applied)
+				applied[game] = stepped;
 		}
 	}
-	Internals::_processRequestOrResponse(input, true);
-}
 
-// 提交决策并退出，下回合时会重新运行程序
-void SubmitAndExit(Action tank0, Action tank1, string debug = "", string data = "", string globalData = "")
-{
-	Internals::_submitAction(tank0, tank1, debug, data, globalData);
-	exit(0);
-}
+	// 第 game 局是否结束？谁赢了？
+	GameResult GetGameResult(int game) const
+	{
+		bool fail[sideCount] = {};
+		for (int side = 0; side < sideCount; side++)
+			if (!(tankAlive[game] >> (side * tankPerSide) & ((1 << tankPerSide) - 1)) || !(baseAlive[game] >> side & 1))
+				fail[side] = true;
+		if (fail[0] == fail[1])
+			return fail[0] || currentTurn[game] > 100 ? Draw : NotFinished;
+		if (fail[Blue])
+			return Red;
+		return Blue;
+	}
 
-// 提交决策，下回合时程序继续运行（需要在 Botzone 上提交 Bot 时选择“允许长时运行”）
-// 如果游戏结束，程序会被系统杀死
-void SubmitAndDontExit(Action tank0, Action tank1)
-{
-	Internals::_submitAction(tank0, tank1);
-	field->nextAction[field->mySide][0] = tank0;
-	field->nextAction[field->mySide][1] = tank1;
-	cout << ">>>BOTZONE_REQUEST_KEEP_RUNNING<<<" << endl;
-}
-#ifdef _MSC_VER
-#pragma endregion
-#endif
-} // namespace TankGame
+  private:
+	static const int tankCount = sideCount * tankPerSide;
 
-int RandBetween(int from, int to)
-{
-	return rand() % (to - from) + from;
-}
+	static int _baseCell(int side)
+	{
+		return baseY[side] * fieldWidth + baseX[side];
+	}
 
-TankGame::Action RandAction(int tank)
-{
-	while (true)
+	// 以下位操作都写成无分支的形式，格子编号随局面变化，分支很难预测
+	static bool _testBit(unsigned long long lo, unsigned long long hi, int cell)
 	{
-		auto act = (TankGame::Action)RandBetween(TankGame::Stay, TankGame::LeftShoot + 1);
-		if (TankGame::field->ActionIsValid(TankGame::field->mySide, tank, act))
-			return act;
+		return ((cell < 64 ? lo : hi) >> (cell & 63)) & 1;
 	}
-}
 
-int dis[15][15][15][15];
-int attack_distance[15][2];
-int safty_block[15][15];
-bool alive[2][2];
-static int enemy_side, my_side;
-std::pair<int, int> enemy_tank[2], my_tank[2];
-//记录上一回合敌方坦克的位置，预判它下一回合可能的移动方向
-std::pair<int, int> last_enemy_tank[2];
-std::pair<int, int> predict_enemy_tank[2];
-
-bool update_safty(TankGame::FieldItem item, int x, int y, int add)
-{ //判断一个格子是否可以被坦克火力覆盖到
-	//add=2 被敌方坦克打到 add=3 被我方坦克打到
-	//一个敌方坦克 2 两个敌方坦克 4 一个敌方一个我方 5 一个我方 3
-	switch (item)
-	{
-	case TankGame::None:
-		safty_block[x][y] += add;
-		break;
-	case TankGame::Brick:
-		safty_block[x][y] += add;
+	static void _setBit(unsigned long long &lo, unsigned long long &hi, int cell)
+	{
+		unsigned long long bit = 1ULL << (cell & 63);
+		lo |= cell < 64 ? bit : 0;
+		hi |= cell < 64 ? 0 : bit;
+	}
+
+	static void _clearBit(unsigned long long &lo, unsigned long long &hi, int cell)
+	{
+		unsigned long long bit = 1ULL << (cell & 63);
+		lo &= cell < 64 ? ~bit : ~0ULL;
+		hi &= cell < 64 ? ~0ULL : ~bit;
+	}
+
+	// 执行第 game 局，返回行为是否合法
+	bool _step(int game, const Action (&act)[sideCount][tankPerSide])
+	{
+		long long pos[tankCount];
+		int alive = tankAlive[game], bases = baseAlive[game];
+		for (int i = 0; i < tankCount; i++)
+			pos[i] = tankPos[i / tankPerSide][i % tankPerSide][game];
+
+		// 1 按移动前的场地检查合法性，与 ActionIsValid 相同
+		unsigned long long fixedLo = brickLo[game] | steelLo[game], fixedHi = brickHi[game] | steelHi[game];
+		for (int side = 0; side < sideCount; side++)
+			if (bases >> side & 1)
+				_setBit(fixedLo, fixedHi, _baseCell(side));
+		unsigned long long lo = fixedLo, hi = fixedHi;
+		for (int i = 0; i < tankCount; i++)
+			if (alive >> i & 1)
+				_setBit(lo, hi, (int)pos[i]);
+		int shoot = 0;
+		for (int i = 0; i < tankCount; i++)
+		{
+			Action a = act[i / tankPerSide][i % tankPerSide];
+			shoot |= ActionIsShoot(a) << i;
+			if (!(alive >> i & 1) || a == Stay)
+				continue;
+			if (a == Invalid || (a > Left && lastShoot[game] >> i & 1))
+				return false;
+			if (a <= Left)
+			{
+				int x = (int)pos[i] % fieldWidth + dx[a], y = (int)pos[i] / fieldWidth + dy[a];
+				if (!CoordValid(x, y) || _testBit(lo, hi, y * fieldWidth + x))
+					return false;
+			}
+		}
+
+		// 2 移动，之后重新计算场地
+		lo = fixedLo;
+		hi = fixedHi;
+		for (int i = 0; i < tankCount; i++)
+		{
+			Action a = act[i / tankPerSide][i % tankPerSide];
+			if (!(alive >> i & 1))
+				continue;
+			if (ActionIsMove(a))
+				pos[i] += dy[a] * fieldWidth + dx[a];
+			_setBit(lo, hi, (int)pos[i]);
+		}
+
+		// 3 追踪炮弹
+		long long hit[tankCount];
+		for (int i = 0; i < tankCount; i++)
+		{
+			Action a = act[i / tankPerSide][i % tankPerSide];
+			hit[i] = -1;
+			if (!(alive >> i & 1) || !ActionIsShoot(a))
+				continue;
+			int dir = ExtractDirectionFromAction(a);
+			int x = (int)pos[i] % fieldWidth, y = (int)pos[i] / fieldWidth;
+			while (true)
+			{
+				x += dx[dir];
+				y += dy[dir];
+				if (!CoordValid(x, y))
+					break;
+				if (_testBit(lo, hi, y * fieldWidth + x))
+				{
+					hit[i] = y * fieldWidth + x;
+					break;
+				}
+			}
+		}
+
+		// 4 对射判断：自己这里和射到的目标格子都只有一个坦克，并且双方射击方向相反
+		for (int i = 0; i < tankCount; i++)
+		{
+			if (hit[i] < 0)
+				continue;
+			int tanksWithMe = 0, tanksThere = 0;
+			Action theirAction = Invalid;
+			for (int j = 0; j < tankCount; j++)
+			{
+				tanksWithMe += pos[j] == pos[i];
+				if (pos[j] == hit[i])
+				{
+					tanksThere++;
+					theirAction = act[j / tankPerSide][j % tankPerSide];
+				}
+			}
+			if (tanksWithMe == 1 && tanksThere == 1 && ActionIsShoot(theirAction) &&
+				ActionDirectionIsOpposite(act[i / tankPerSide][i % tankPerSide], theirAction))
+				hit[i] = -1;
+		}
+
+		// 5 摧毁命中格子上的物件（钢墙除外）
+		for (int i = 0; i < tankCount; i++)
+		{
+			if (hit[i] < 0)
+				continue;
+			int cell = (int)hit[i];
+			_clearBit(brickLo[game], brickHi[game], cell);
+			for (int side = 0; side < sideCount; side++)
+				if (cell == _baseCell(side))
+					bases &= ~(1 << side);
+			for (int j = 0; j < tankCount; j++)
+				if (pos[j] == cell)
+				{
+					pos[j] = -1;
+					alive &= ~(1 << j);
+				}
+		}
+
+		for (int i = 0; i < tankCount; i++)
+			tankPos[i / tankPerSide][i % tankPerSide][game] = pos[i];
+		tankAlive[game] = alive;
+		baseAlive[game] = bases;
+		lastShoot[game] = shoot;
+		currentTurn[game]++;
+		return true;
+	}
+
+#ifdef __AVX2__
+	static __m256i _load32(const int *p)
+	{
+		return _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)p));
+	}
+
+	static void _store32(int *p, __m256i value)
+	{
+		__m256i packed = _mm256_permutevar8x32_epi32(value, _mm256_setr_epi32(0, 2, 4, 6, 0, 0, 0, 0));
+		_mm_storeu_si128((__m128i *)p, _mm256_castsi256_si128(packed));
+	}
+
+	// 每条通道中 bits 的第 bit 位是否为 1
+	static __m256i _hasBit(__m256i bits, int bit)
+	{
+		__m256i mask = _mm256_set1_epi64x(1LL << bit);
+		return _mm256_cmpeq_epi64(_mm256_and_si256(bits, mask), mask);
+	}
+
+	static __m256i _testBits(__m256i lo, __m256i hi, __m256i cell)
+	{
+		__m256i word = _mm256_blendv_epi8(hi, lo, _mm256_cmpgt_epi64(_mm256_set1_epi64x(64), cell));
+		__m256i one = _mm256_set1_epi64x(1);
+		return _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_srlv_epi64(word, _mm256_and_si256(cell, _mm256_set1_epi64x(63))), one), one);
+	}
+
+	// 在 mask 为真的通道中设置或清除 cell 对应的位
+	static __m256i _cellBit(__m256i cell, __m256i mask, bool low)
+	{
+		__m256i bit = _mm256_and_si256(_mm256_sllv_epi64(_mm256_set1_epi64x(1), _mm256_and_si256(cell, _mm256_set1_epi64x(63))), mask);
+		__m256i isLow = _mm256_cmpgt_epi64(_mm256_set1_epi64x(64), cell);
+		return low ? _mm256_and_si256(bit, isLow) : _mm256_andnot_si256(isLow, bit);
+	}
+
+	// 格子编号除以 9（对 0~80 准确）
+	static __m256i _row(__m256i cell)
+	{
+		return _mm256_srli_epi64(_mm256_mul_epu32(cell, _mm256_set1_epi64x(57)), 9);
+	}
+
+	// 同时执行 game ~ game + 3 这四局，每条 64 位通道对应一局，逻辑与 _step 完全相同
+	void _stepAVX2(int game, const Action (*actions)[sideCount][tankPerSide], bool *applied)
+	{
+		const __m256i zero = _mm256_setzero_si256(), allOnes = _mm256_set1_epi64x(-1),
+					  size = _mm256_set1_epi64x(fieldWidth), three = _mm256_set1_epi64x(3);
+		__m256i alive = _load32(&tankAlive[game]), bases = _load32(&baseAlive[game]),
+				shootBefore = _load32(&lastShoot[game]);
+		__m256i bricksLo = _mm256_loadu_si256((const __m256i *)&brickLo[game]),
+				bricksHi = _mm256_loadu_si256((const __m256i *)&brickHi[game]);
+		__m256i fixedLo = _mm256_or_si256(bricksLo, _mm256_loadu_si256((const __m256i *)&steelLo[game])),
+				fixedHi = _mm256_or_si256(bricksHi, _mm256_loadu_si256((const __m256i *)&steelHi[game]));
+		for (int side = 0; side < sideCount; side++)
+		{
+			__m256i cell = _mm256_set1_epi64x(_baseCell(side)), baseMask = _hasBit(bases, side);
+			fixedLo = _mm256_or_si256(fixedLo, _cellBit(cell, baseMask, true));
+			fixedHi = _mm256_or_si256(fixedHi, _cellBit(cell, baseMask, false));
+		}
+
+		// 动作按 [game][side][tank] 存放，每局 tankCount 个 int
+		static_assert(sizeof(Action) == sizeof(int), "Action must be int-sized");
+		const int *actionBase = (const int *)actions[game];
+		__m256i pos[tankCount], act[tankCount], aliveMask[tankCount], isMove[tankCount], isShoot[tankCount],
+			stepX[tankCount], stepY[tankCount];
+		__m256i lo = fixedLo, hi = fixedHi;
+		for (int i = 0; i < tankCount; i++)
+		{
+			pos[i] = _mm256_loadu_si256((const __m256i *)&tankPos[i / tankPerSide][i % tankPerSide][game]);
+			act[i] = _mm256_cvtepi32_epi64(_mm_i32gather_epi32(actionBase, _mm_setr_epi32(i, tankCount + i, tankCount * 2 + i, tankCount * 3 + i), 4));
+			aliveMask[i] = _hasBit(alive, i);
+			isShoot[i] = _mm256_cmpgt_epi64(act[i], three);
+			isMove[i] = _mm256_andnot_si256(isShoot[i], _mm256_cmpgt_epi64(act[i], allOnes));
+			// 方向：0 上 1 右 2 下 3 左
+			__m256i dir = _mm256_and_si256(act[i], three);
+			stepX[i] = _mm256_sub_epi64(_mm256_cmpeq_epi64(dir, three), _mm256_cmpeq_epi64(dir, _mm256_set1_epi64x(1)));
+			stepY[i] = _mm256_sub_epi64(_mm256_cmpeq_epi64(dir, zero), _mm256_cmpeq_epi64(dir, _mm256_set1_epi64x(2)));
+			lo = _mm256_or_si256(lo, _cellBit(pos[i], aliveMask[i], true));
+			hi = _mm256_or_si256(hi, _cellBit(pos[i], aliveMask[i], false));
+		}
+
+		// 1 按移动前的场地检查合法性
+		__m256i invalid = zero, shoot = zero;
+		for (int i = 0; i < tankCount; i++)
+		{
+			__m256i y = _row(pos[i]), x = _mm256_sub_epi64(pos[i], _mm256_add_epi64(_mm256_slli_epi64(y, 3), y));
+			x = _mm256_add_epi64(x, stepX[i]);
+			y = _mm256_add_epi64(y, stepY[i]);
+			__m256i inside = _mm256_and_si256(
+				_mm256_and_si256(_mm256_cmpgt_epi64(x, allOnes), _mm256_cmpgt_epi64(size, x)),
+				_mm256_and_si256(_mm256_cmpgt_epi64(y, allOnes), _mm256_cmpgt_epi64(size, y)));
+			__m256i target = _mm256_add_epi64(_mm256_add_epi64(_mm256_slli_epi64(y, 3), y), x);
+			__m256i blocked = _mm256_or_si256(_mm256_xor_si256(inside, allOnes), _testBits(lo, hi, target));
+			__m256i bad = _mm256_or_si256(_mm256_cmpeq_epi64(act[i], _mm256_set1_epi64x(Invalid)),
+										  _mm256_or_si256(_mm256_and_si256(isShoot[i], _hasBit(shootBefore, i)),
+														  _mm256_and_si256(isMove[i], blocked)));
+			invalid = _mm256_or_si256(invalid, _mm256_and_si256(aliveMask[i], bad));
+			shoot = _mm256_or_si256(shoot, _mm256_and_si256(isShoot[i], _mm256_set1_epi64x(1LL << i)));
+		}
+		__m256i valid = _mm256_xor_si256(invalid, allOnes);
+
+		// 2 移动，之后重新计算场地
+		lo = fixedLo;
+		hi = fixedHi;
+		for (int i = 0; i < tankCount; i++)
+		{
+			aliveMask[i] = _mm256_and_si256(aliveMask[i], valid);
+			__m256i delta = _mm256_add_epi64(_mm256_add_epi64(_mm256_slli_epi64(stepY[i], 3), stepY[i]), stepX[i]);
+			pos[i] = _mm256_add_epi64(pos[i], _mm256_and_si256(_mm256_and_si256(aliveMask[i], isMove[i]), delta));
+			lo = _mm256_or_si256(lo, _cellBit(pos[i], _hasBit(alive, i), true));
+			hi = _mm256_or_si256(hi, _cellBit(pos[i], _hasBit(alive, i), false));
+		}
+
+		// 3 追踪炮弹，9x9 的场地上炮弹最多飞 8 格
+		__m256i hit[tankCount];
+		for (int i = 0; i < tankCount; i++)
+		{
+			__m256i active = _mm256_and_si256(aliveMask[i], isShoot[i]);
+			__m256i y = _row(pos[i]), x = _mm256_sub_epi64(pos[i], _mm256_add_epi64(_mm256_slli_epi64(y, 3), y));
+			hit[i] = allOnes;
+			for (int step = 1; step < fieldWidth && !_mm256_testz_si256(active, active); step++)
+			{
+				x = _mm256_add_epi64(x, stepX[i]);
+				y = _mm256_add_epi64(y, stepY[i]);
+				__m256i inside = _mm256_and_si256(
+					_mm256_and_si256(_mm256_cmpgt_epi64(x, allOnes), _mm256_cmpgt_epi64(size, x)),
+					_mm256_and_si256(_mm256_cmpgt_epi64(y, allOnes), _mm256_cmpgt_epi64(size, y)));
+				active = _mm256_and_si256(active, inside);
+				__m256i cell = _mm256_add_epi64(_mm256_add_epi64(_mm256_slli_epi64(y, 3), y), x);
+				__m256i found = _mm256_and_si256(active, _testBits(lo, hi, cell));
+				hit[i] = _mm256_blendv_epi8(hit[i], cell, found);
+				active = _mm256_andnot_si256(found, active);
+			}
+		}
+
+		// 没有任何炮弹命中时后面两步都可以跳过
+		__m256i anyHit = zero;
+		for (int i = 0; i < tankCount; i++)
+			anyHit = _mm256_or_si256(anyHit, _mm256_cmpgt_epi64(hit[i], allOnes));
+		if (!_mm256_testz_si256(anyHit, anyHit))
+			_resolveShotsAVX2(pos, act, hit, alive, bases, bricksLo, bricksHi);
+
+		for (int i = 0; i < tankCount; i++)
+			_mm256_storeu_si256((__m256i *)&tankPos[i / tankPerSide][i % tankPerSide][game], pos[i]);
+		_mm256_storeu_si256((__m256i *)&brickLo[game], bricksLo);
+		_mm256_storeu_si256((__m256i *)&brickHi[game], bricksHi);
+		_store32(&tankAlive[game], alive);
+		_store32(&baseAlive[game], bases);
+		_store32(&lastShoot[game], _mm256_blendv_epi8(shootBefore, shoot, valid));
+		_store32(&currentTurn[game], _mm256_sub_epi64(_load32(&currentTurn[game]), valid));
+		if (applied)
+		{
+			int validBits = _mm256_movemask_pd(_mm256_castsi256_pd(valid));
+			for (int i = 0; i < 4; i++)
+				applied[game + i] = validBits >> i & 1;
+		}
+	}
+
+	// _stepAVX2 的第 4、5 步：对射判断，然后摧毁命中格子上的物件
+	static void _resolveShotsAVX2(__m256i pos[tankCount], const __m256i act[tankCount], __m256i hit[tankCount],
+								  __m256i &alive, __m256i &bases, __m256i &bricksLo, __m256i &bricksHi)
+	{
+		const __m256i zero = _mm256_setzero_si256(), allOnes = _mm256_set1_epi64x(-1),
+					  one = _mm256_set1_epi64x(1), three = _mm256_set1_epi64x(3);
+		for (int i = 0; i < tankCount; i++)
+		{
+			__m256i tanksWithMe = zero, tanksThere = zero, theirAction = _mm256_set1_epi64x(Invalid);
+			for (int j = 0; j < tankCount; j++)
+			{
+				__m256i there = _mm256_cmpeq_epi64(pos[j], hit[i]);
+				tanksWithMe = _mm256_sub_epi64(tanksWithMe, _mm256_cmpeq_epi64(pos[j], pos[i]));
+				tanksThere = _mm256_sub_epi64(tanksThere, there);
+				theirAction = _mm256_blendv_epi8(theirAction, act[j], there);
+			}
+			__m256i opposite = _mm256_cmpeq_epi64(
+				_mm256_and_si256(_mm256_xor_si256(_mm256_add_epi64(act[i], _mm256_set1_epi64x(2)), theirAction), three), zero);
+			__m256i cancel = _mm256_and_si256(
+				_mm256_and_si256(_mm256_cmpeq_epi64(tanksWithMe, one), _mm256_cmpeq_epi64(tanksThere, one)),
+				_mm256_and_si256(_mm256_cmpgt_epi64(theirAction, three), opposite));
+			hit[i] = _mm256_or_si256(hit[i], _mm256_and_si256(cancel, _mm256_cmpgt_epi64(hit[i], allOnes)));
+		}
+
+		for (int i = 0; i < tankCount; i++)
+		{
+			__m256i hasHit = _mm256_cmpgt_epi64(hit[i], allOnes);
+			bricksLo = _mm256_andnot_si256(_cellBit(hit[i], hasHit, true), bricksLo);
+			bricksHi = _mm256_andnot_si256(_cellBit(hit[i], hasHit, false), bricksHi);
+			for (int side = 0; side < sideCount; side++)
+				bases = _mm256_andnot_si256(_mm256_and_si256(_mm256_cmpeq_epi64(hit[i], _mm256_set1_epi64x(_baseCell(side))),
+															 _mm256_set1_epi64x(1LL << side)),
+											bases);
+			for (int j = 0; j < tankCount; j++)
+			{
+				__m256i killed = _mm256_and_si256(hasHit, _mm256_cmpeq_epi64(pos[j], hit[i]));
+				pos[j] = _mm256_or_si256(pos[j], killed);
+				alive = _mm256_andnot_si256(_mm256_and_si256(killed, _mm256_set1_epi64x(1LL << j)), alive);
+			}
+		}
+	}
+#endif
+};
+
+#ifdef _MSC_VER
+#pragma endregion
+#endif
+#endif
+
+#ifdef _MSC_VER
+#pragma region MapGenerator 地图生成
+#endif
+
+// 按 Botzone 的规则随机生成场地，输出的格式与 TankField 的构造函数相同
+// 场地关于中心对称（格子 (x, y) 与 (8 - x, 8 - y) 相同），出生点、基地和基地前的钢墙上不会有砖块
+// 相同的种子总是生成相同的场地序列
+class MapGenerator
+{
+  public:
+	// brickPercent 为每个格子是砖块的概率（百分比）
+	explicit MapGenerator(unsigned long long seed, int brickPercent = 33)
+		: state(seed), threshold(brickPercent * 256 / 100) {}
+
+	void Next(int hasBrick[3])
+	{
+		// 格子编号为 y * fieldWidth + x，只需要决定前一半（含中心）的格子，另一半由对称得到
+		const int cellCount = fieldHeight * fieldWidth, half = cellCount / 2;
+		unsigned long long lo = 0, hi = 0, random = 0;
+		for (int cell = 0; cell <= half; cell++)
+		{
+			if (cell % 8 == 0)
+				random = _next();
+			bool brick = (int)(random & 0xFF) < threshold;
+			random >>= 8;
+			if (!brick || _isReserved(cell))
+				continue;
+			int mirror = cellCount - 1 - cell;
+			lo |= 1ULL << cell; // 前一半的格子编号都小于 64
+			if (mirror < 64)
+				lo |= 1ULL << mirror;
+			else
+				hi |= 1ULL << (mirror - 64);
+		}
+		const int rowMask = (1 << 27) - 1;
+		hasBrick[0] = (int)(lo & rowMask);
+		hasBrick[1] = (int)((lo >> 27) & rowMask);
+		hasBrick[2] = (int)(((lo >> 54) | (hi << 10)) & rowMask);
+	}
+
+  private:
+	unsigned long long state;
+	int threshold;
+
+	unsigned long long _next()
+	{
+		return SplitMix64(state);
+	}
+
+	// 出生点、基地和基地前的钢墙所在的格子（只看蓝方，红方的由对称得到）
+	static bool _isReserved(int cell)
+	{
+		int x = cell % fieldWidth, y = cell / fieldWidth;
+		if (x == baseX[Blue])
+			return y == baseY[Blue] || y == baseY[Blue] + 1;
+		return y == baseY[Blue] && (x == baseX[Blue] - 2 || x == baseX[Blue] + 2);
+	}
+};
+
+#ifdef _MSC_VER
+#pragma endregion
+#endif
+
+#ifdef _MSC_VER
+#pragma region Profiler 分阶段计时
+#endif
+
+// 每回合各阶段的耗时统计，x86 上用时间戳计数器（TSC）计时，每次计时只有几十个周期的开销
+// 简要结果放进每回合输出的 debug，本地运行时可以另把每回合的完整耗时追加到 profileLogPath（见 main 中的 local_logs）
+namespace Profiler
+{
+enum Phase
+{
+	ReadPhase,     // 读取输入（长时运行时包括等待平台发来下一回合的时间）
+	ParsePhase,    // 解析 JSON
+	ReplayPhase,   // 恢复存档并在 TankField 上执行动作
+	DistancePhase, // DistanceCache 取得距离表（砖块有变化时需要重新计算）
+	AttackPhase,   // update_attack_distance
+	ThreatPhase,   // 预测对方移动和计算双方火力范围
+	DecidePhase,   // MyAction（不含其中按需进行的上面三项）
+	OutputPhase,   // 生成存档并输出
+	phaseCount
+};
+
+const char *const phaseNames[phaseCount] = {
+	"read", "parse", "replay", "dist", "attack", "threat", "decide", "output"};
+
+// AppendLog 每回合在这个文件末尾追加一行，记录这一回合各阶段的耗时
+const char *const profileLogPath = "tank_profile.log";
+
+struct Stats
+{
+	// 本回合和上一回合各阶段的耗时（输出阶段在生成本回合的 debug 时还没有结束，只能给出上一回合的）
+	unsigned long long turn[phaseCount], last[phaseCount];
+
+	// 用于把计时单位换算成微秒
+	unsigned long long startTicks;
+	std::chrono::steady_clock::time_point startTime;
+};
+
+thread_local Stats stats;
+
+inline unsigned long long Now()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+class ScopedTimer;
+
+// 当前正在计时的最内层计时器
+thread_local ScopedTimer *activeTimer = nullptr;
+
+// 在作用域内为某个阶段计时，可以用 Switch 直接切换到下一个阶段
+// 计时器可以嵌套：内层计时期间外层暂停，结束后外层继续，每段时间只记在一个阶段上，各阶段之和即为总耗时
+class ScopedTimer
+{
+  public:
+	explicit ScopedTimer(Phase phase) : phase(phase), start(Now()), outer(activeTimer)
+	{
+		if (!stats.startTicks)
+		{
+			stats.startTicks = start;
+			stats.startTime = std::chrono::steady_clock::now();
+		}
+		if (outer)
+			stats.turn[outer->phase] += start - outer->start;
+		activeTimer = this;
+	}
+
+	~ScopedTimer()
+	{
+		unsigned long long now = Now();
+		stats.turn[phase] += now - start;
+		if (outer)
+			outer->start = now;
+		activeTimer = outer;
+	}
+
+	ScopedTimer(const ScopedTimer &) = delete;
+	ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+	void Switch(Phase next)
+	{
+		unsigned long long now = Now();
+		stats.turn[phase] += now - start;
+		phase = next;
+		start = now;
+	}
+
+  private:
+	Phase phase;
+	unsigned long long start;
+	ScopedTimer *outer;
+};
+
+// 每微秒的计时单位数，用第一次计时以来的时间校准
+inline double TicksPerMicrosecond()
+{
+	double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - stats.startTime).count();
+	return elapsed > 0 && stats.startTicks ? (Now() - stats.startTicks) / elapsed : 1;
+}
+
+// 把各阶段的耗时写成 "read:12 parse:3 ... us" 的形式追加到 out 末尾
+inline void _format(string &out, const unsigned long long ticks[phaseCount])
+{
+	double scale = TicksPerMicrosecond();
+	char number[24];
+	for (int phase = 0; phase < phaseCount; phase++)
+	{
+		if (phase)
+			out += ' ';
+		out += phaseNames[phase];
+		out += ':';
+		snprintf(number, sizeof(number), "%lld", (long long)(ticks[phase] / scale + 0.5));
+		out += number;
+	}
+	out += " us";
+}
+
+// 本回合各阶段的耗时（微秒），输出阶段为上一回合的
+// 结果放在每个线程复用的缓冲区中，下次调用前有效
+inline const string &Summary()
+{
+	thread_local string out;
+	unsigned long long ticks[phaseCount];
+	for (int phase = 0; phase < phaseCount; phase++)
+		ticks[phase] = phase == OutputPhase ? stats.last[phase] : stats.turn[phase];
+	out.clear();
+	_format(out, ticks);
+	return out;
+}
+
+// 在提交之前把本回合的耗时追加到 profileLogPath，内容与 Summary 相同（输出阶段为上一回合的）
+// 文件在第一次写入时打开，之后一直保持打开；程序提交后可能退出或被直接杀死，因此每行都立即写出
+inline void AppendLog(int turn)
+{
+	static FILE *log = fopen(profileLogPath, "a");
+	if (!log)
+		return;
+	fprintf(log, "turn %d %s\n", turn, Summary().c_str());
+	fflush(log);
+}
+
+// 一回合结束时调用，各阶段的计时器都应已结束
+inline void EndTurn()
+{
+	for (int phase = 0; phase < phaseCount; phase++)
+	{
+		stats.last[phase] = stats.turn[phase];
+		stats.turn[phase] = 0;
+	}
+}
+} // namespace Profiler
+
+#ifdef _MSC_VER
+#pragma endregion
+#endif
+
+// 任意两格之间的距离（需要走的回合数，打掉砖块算两回合），用 Floyd 算出
+// 距离只和砖块的分布有关，因此以砖块的分布为键缓存最近一次的结果：同一局中双方（例如本地对战时）、
+// 以及砖块没有变化的各回合都共用同一张表
+class DistanceCache
+{
+  public:
+	// 下标为 [y1][x1][y2][x2]；数组比场地大，场地之外的格子距离均为 0x3f3f3f3f
+	typedef int Table[15][15][15][15];
+
+	// field 的距离表，在下一次以不同的砖块分布调用 Get 之前有效（表的地址不变）
+	const Table &Get(const TankField &field)
+	{
+		Profiler::ScopedTimer timer(Profiler::DistancePhase);
+		int signature[3];
+		_brickSignature(field, signature);
+		if (!valid || memcmp(signature, this->signature, sizeof(signature)) != 0)
+		{
+			_compute(field);
+			memcpy(this->signature, signature, sizeof(signature));
+			valid = true;
+		}
+		return storage->dis;
+	}
+
+	// 丢弃缓存的结果，下次 Get 时重新计算（例如用于测量计算的耗时）
+	void Invalidate()
+	{
+		valid = false;
+	}
+
+  private:
+	struct Storage
+	{
+		Table dis;
+	};
+
+	// 约 200KB，第一次计算时在堆上分配
+	std::unique_ptr<Storage> storage;
+	int signature[3] = {};
+	bool valid = false;
+
+	void _compute(const TankField &field)
+	{
+		if (!storage)
+			storage.reset(new Storage);
+		Table &dis = storage->dis;
+		memset(dis, 0x3f, sizeof(dis));
+		for (int i = 0; i < fieldHeight; i++)
+			for (int j = 0; j < fieldWidth; j++)
+			{
+				dis[i][j][i][j] = 0;
+				for (int k = 0; k < 4; k++)
+				{
+					int y = i + dy[k], x = j + dx[k];
+					if (!CoordValid(x, y) || field.gameField[y][x] == Steel)
+						continue;
+					dis[i][j][y][x] = field.gameField[y][x] == Brick ? 2 : 1;
+				}
+			}
+		for (int ki = 0; ki < fieldHeight; ki++)
+			for (int kj = 0; kj < fieldWidth; kj++)
+				for (int i = 0; i < fieldHeight; i++)
+					for (int j = 0; j < fieldWidth; j++)
+						for (int ii = 0; ii < fieldHeight; ii++)
+							for (int jj = 0; jj < fieldWidth; jj++)
+								dis[i][j][ii][jj] = std::min(dis[i][j][ii][jj], dis[i][j][ki][kj] + dis[ki][kj][ii][jj]);
+	}
+
+	// 格式与 TankField 的构造函数相同：每个 int 用 27 位表示 3 行中的砖块
+	static void _brickSignature(const TankField &field, int signature[3])
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			signature[i] = 0;
+			for (int y = i * 3; y < (i + 1) * 3; y++)
+				for (int x = 0; x < fieldWidth; x++)
+					if (field.gameField[y][x] == Brick)
+						signature[i] |= 1 << ((y - i * 3) * fieldWidth + x);
+		}
+	}
+};
+
+// 一局游戏中与平台交互的状态，由 ReadInput 填充
+// 每局使用自己的 GameContext，一个进程中可以同时进行多局（例如本地工具的多个线程）
+struct GameContext
+{
+	// 第一回合裁判介绍场地时创建
+	std::unique_ptr<TankField> field;
+
+	// 这一局的距离表，双方做决策时共用
+	DistanceCache distances;
+
+	// 本局的初始砖块分布，用于确认存档属于本局
+	int fieldMasks[3] = {};
+
+	// 已经处理过的 request 数量
+	size_t processedRequests = 0;
+};
+
+#ifdef _MSC_VER
+#pragma region 与平台交互部分
+#endif
+
+// 内部函数
+namespace Internals
+{
+// 每回合复用的输入缓冲区，避免反复分配
+thread_local string inputBuffer;
+
+// 解析器和解析结果只在一次调用中使用，不属于任何一局，按线程复用
+#ifndef _BOTZONE_ONLINE
+// 输入由平台生成，不含注释，也用不到位置信息，因此用 fast 配置只做建索引必需的工作
+thread_local Json::Reader reader(Json::Features::fast());
+
+// 输入的 JSON 只建立索引，数字和字符串在读取时才解码，并直接引用 inputBuffer 中的文本
+// 大部分历史回合只用到两个整数，不必为整棵树构造 Json::Value
+thread_local Json::LazyDocument inputDocument;
+typedef Json::LazyValue InputValue;
+
+inline InputValue _parseInput(const string &text)
+{
+	reader.parse(text, inputDocument);
+	return inputDocument.root();
+}
+#else
+// Botzone 上用平台自带的原版 jsoncpp 编译，没有 Features::fast 和 LazyDocument，解析成完整的 Json::Value
+thread_local Json::Reader reader;
+thread_local Json::Value inputDocument;
+typedef Json::Value InputValue;
+
+inline const InputValue &_parseInput(const string &text)
+{
+	reader.parse(text, inputDocument);
+	return inputDocument;
+}
+#endif
+
+// 存档格式的标记和版本
+const char checkpointMagic[] = {'T', 'K', 1};
+const char checkpointPrefix[] = "VEsB"; // checkpointMagic 经 base64 编码后的开头
+const size_t checkpointHeaderSize = sizeof(checkpointMagic) + 2 + 3 * 4;
+
+const char base64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+void _base64Encode(const string &in, string &out)
+{
+	const unsigned char *p = (const unsigned char *)in.data(), *end = p + in.size();
+	out.reserve(out.size() + (in.size() + 2) / 3 * 4);
+	for (; end - p >= 3; p += 3)
+	{
+		unsigned int v = p[0] << 16 | p[1] << 8 | p[2];
+		out += base64Chars[v >> 18];
+		out += base64Chars[v >> 12 & 63];
+		out += base64Chars[v >> 6 & 63];
+		out += base64Chars[v & 63];
+	}
+	if (p != end)
+	{
+		unsigned int v = p[0] << 16 | (end - p > 1 ? p[1] << 8 : 0);
+		out += base64Chars[v >> 18];
+		out += base64Chars[v >> 12 & 63];
+		out += end - p > 1 ? base64Chars[v >> 6 & 63] : '=';
+		out += '=';
+	}
+}
+
+// 遇到非法字符时返回 false
+bool _base64Decode(const string &in, string &out)
+{
+	static signed char table[256];
+	if (!table['B'])
+	{
+		memset(table, -1, sizeof(table));
+		for (int i = 0; i < 64; i++)
+			table[(unsigned char)base64Chars[i]] = (signed char)i;
+	}
+	out.clear();
+	out.reserve(in.size() / 4 * 3);
+	unsigned int v = 0;
+	int bits = 0;
+	for (size_t i = 0; i < in.size() && in[i] != '='; i++)
+	{
+		int c = table[(unsigned char)in[i]];
+		if (c < 0)
+			return false;
+		v = v << 6 | c;
+		if ((bits += 6) >= 8)
+		{
+			bits -= 8;
+			out += (char)(v >> bits & 255);
+		}
+	}
+	return true;
+}
+
+// FNV-1a 校验和
+unsigned int _checksum(const char *p, size_t size)
+{
+	unsigned int hash = 2166136261U;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ (unsigned char)p[i]) * 16777619U;
+	return hash;
+}
+
+inline void _appendUInt32(string &out, unsigned int value)
+{
+	for (int i = 0; i < 4; i++)
+		out += (char)(value >> (i * 8) & 255);
+}
+
+inline unsigned int _readUInt32(const unsigned char *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (unsigned int)p[3] << 24;
+}
+
+// 尝试用 data 中的存档代替回放：存档须校验通过，并且与 firstRequest 描述的场地和 requestCount 相符
+// 成功时创建 game.field，resumeFrom 为接下来要处理的 request 下标，extra 为存档附带的数据
+bool _restoreCheckpoint(GameContext &game, const string &data, const InputValue &firstRequest, size_t requestCount,
+						size_t &resumeFrom, string &extra)
+{
+	string binary;
+	if (!_base64Decode(data, binary) || binary.size() < checkpointHeaderSize + 4 ||
+		memcmp(binary.data(), checkpointMagic, sizeof(checkpointMagic)) != 0)
+		return false;
+	size_t payloadSize = binary.size() - 4;
+	if (_checksum(binary.data(), payloadSize) != _readUInt32((const unsigned char *)binary.data() + payloadSize))
+		return false;
+
+	const unsigned char *p = (const unsigned char *)binary.data() + sizeof(checkpointMagic),
+						*end = (const unsigned char *)binary.data() + payloadSize;
+	size_t consumed = p[0] | p[1] << 8;
+	p += 2;
+	if (consumed < 1 || consumed > requestCount || !firstRequest.isObject())
+		return false;
+	int masks[3];
+	for (int i = 0; i < 3; i++, p += 4)
+	{
+		masks[i] = (int)_readUInt32(p);
+		if (masks[i] != firstRequest["field"][i].asInt())
+			return false;
+	}
+
+	std::unique_ptr<TankField> restored(new TankField(masks, firstRequest["mySide"].asInt()));
+	int side = restored->mySide;
+	if (!restored->LoadSnapshot(p, end) || restored->mySide != side)
+		return false;
+	game.field = std::move(restored);
+	memcpy(game.fieldMasks, masks, sizeof(game.fieldMasks));
+	game.processedRequests = resumeFrom = consumed;
+	extra.assign((const char *)p, end - p);
+	return true;
+}
+
+// 手写的整数扫描（允许前后空白和负号），成功时返回扫描结束的位置，否则返回 nullptr
+inline const char *_scanInt(const char *p, int &out)
+{
+	while (*p == ' ' || *p == '\t' || *p == '\r')
+		p++;
+	bool negative = *p == '-';
+	if (negative)
+		p++;
+	if (*p < '0' || *p > '9')
+		return nullptr;
+	int value = 0;
+	do
+		value = value * 10 + (*p++ - '0');
+	while (*p >= '0' && *p <= '9' && value < 1000);
+	out = negative ? -value : value;
+	while (*p == ' ' || *p == '\t' || *p == '\r')
+		p++;
+	return p;
+}
+
+// 识别长时运行模式下每回合形如 [a,b] 的输入，不符合该形式时返回 false
+bool _tryParseActionPair(const string &line, int actions[tankPerSide])
+{
+	const char *p = line.c_str();
+	while (*p == ' ' || *p == '\t')
+		p++;
+	if (*p++ != '[')
+		return false;
+	for (int tank = 0; tank < tankPerSide; tank++)
+	{
+		if (!(p = _scanInt(p, actions[tank])))
+			return false;
+		if (*p++ != (tank == tankPerSide - 1 ? ']' : ','))
+			return false;
+	}
+	while (*p == ' ' || *p == '\t' || *p == '\r')
+		p++;
+	return *p == '\0';
+}
+
+// fastForward 为 true 时表示在回放历史，用 FastForward 代替 DoAction
+void _processActions(GameContext &game, const int actions[tankPerSide], bool isOpponent, bool fastForward = false)
+{
+	TankField *field = game.field.get();
+	int side = isOpponent ? 1 - field->mySide : field->mySide;
+	for (int tank = 0; tank < tankPerSide; tank++)
+		field->nextAction[side][tank] = (Action)actions[tank];
+	if (isOpponent)
+	{
+		if (fastForward)
+			field->FastForward();
+		else
+			field->DoAction();
+		game.processedRequests++;
+	}
+}
+
+void _processRequestOrResponse(GameContext &game, const InputValue &value, bool isOpponent, bool fastForward = false)
+{
+	if (value.isArray())
+	{
+		int actions[tankPerSide];
+		for (int tank = 0; tank < tankPerSide; tank++)
+			actions[tank] = value[tank].asInt();
+		_processActions(game, actions, isOpponent, fastForward);
+	}
+	else
+	{
+		// 是第一回合，裁判在介绍场地
+		int hasBrick[3];
+		for (int i = 0; i < 3; i++)
+			game.fieldMasks[i] = hasBrick[i] = value["field"][i].asInt();
+		game.field.reset(new TankField(hasBrick, value["mySide"].asInt()));
+		game.processedRequests = 1;
+	}
+}
+
+// 每回合复用的输出缓冲区，整份输出拼好后一次性写出
+thread_local string outputBuffer;
+
+inline void _appendInt(string &out, int value)
+{
+	char digits[12];
+	int n = 0;
+	unsigned int magnitude = value < 0 ? 0U - (unsigned int)value : (unsigned int)value;
+	do
+		digits[n++] = (char)('0' + magnitude % 10);
+	while (magnitude /= 10);
+	if (value < 0)
+		out += '-';
+	while (n)
+		out += digits[--n];
+}
+
+// 以 JSON 字符串的形式追加（带引号并转义），不需要转义的片段整段拷贝
+void _appendEscaped(string &out, const string &str)
+{
+	static const char hex[] = "0123456789abcdef";
+	const char *p = str.data(), *end = p + str.size(), *run = p;
+	out += '"';
+	for (; p != end; p++)
+	{
+		unsigned char c = (unsigned char)*p;
+		if (c >= 0x20 && c != '"' && c != '\\')
+			continue;
+		out.append(run, p);
+		run = p + 1;
+		switch (c)
+		{
+		case '"':
+			out += "\\\"";
+			break;
+		case '\\':
+			out += "\\\\";
+			break;
+		case '\n':
+			out += "\\n";
+			break;
+		case '\r':
+			out += "\\r";
+			break;
+		case '\t':
+			out += "\\t";
+			break;
+		default:
+			out += "\\u00";
+			out += hex[c >> 4];
+			out += hex[c & 15];
+		}
+	}
+	out.append(run, p);
+	out += '"';
+}
+
+// 把缓冲区一次性写到标准输出
+void _flushOutput(const string &out)
+{
+	// 先清空 cout/stdout 中可能残留的调试输出，保证顺序
+	fflush(stdout);
+	const char *p = out.data();
+	size_t left = out.size();
+#ifdef _MSC_VER
+	fwrite(p, 1, left, stdout);
+	fflush(stdout);
+#else
+	while (left)
+	{
+		ssize_t written = write(STDOUT_FILENO, p, left);
+		if (written <= 0)
+			break;
+		p += written;
+		left -= written;
+	}
+#endif
+}
+
+// 请使用 SubmitAndExit 或者 SubmitAndDontExit
+void _submitAction(Action tank0, Action tank1, const string &debug, const string &data,
+				   const string &globalData, bool keepRunning)
+{
+	string &out = outputBuffer;
+	out.clear();
+	out += "{\"response\":[";
+	_appendInt(out, tank0);
+	out += ',';
+	_appendInt(out, tank1);
+	out += ']';
+	if (!debug.empty())
+	{
+		out += ",\"debug\":";
+		_appendEscaped(out, debug);
+	}
+	if (!data.empty())
+	{
+		out += ",\"data\":";
+		_appendEscaped(out, data);
+	}
+	if (!globalData.empty())
+	{
+		out += ",\"globalData\":";
+		_appendEscaped(out, globalData);
+	}
+	out += "}\n";
+	if (keepRunning)
+		out += ">>>BOTZONE_REQUEST_KEEP_RUNNING<<<\n";
+	_flushOutput(out);
+}
+} // namespace Internals
+
+// 从输入流（例如 cin 或者 fstream）读取回合信息，存入 game.field，并提取上回合存储的 data 和 globaldata
+// 本地调试的时候支持多行，但是最后一行需要以没有缩进的一个"}"或"]"结尾
+void ReadInput(GameContext &game, istream &in, string &outData, string &outGlobalData)
+{
+	string &inputString = Internals::inputBuffer;
+	Profiler::ScopedTimer timer(Profiler::ReadPhase);
+	do
+	{
+		getline(in, inputString);
+	} while (inputString.empty());
+
+	// 快速路径：长时运行时每回合只有对方的两个动作
+	int actions[tankPerSide];
+	timer.Switch(Profiler::ParsePhase);
+	if (game.field && Internals::_tryParseActionPair(inputString, actions))
+	{
+		timer.Switch(Profiler::ReplayPhase);
+		Internals::_processActions(game, actions, true);
+		return;
+	}
+
+#ifndef _BOTZONE_ONLINE
+	// 猜测是单行还是多行
+	char lastChar = inputString[inputString.size() - 1];
+	if (lastChar != '}' && lastChar != ']')
+	{
+		// 第一行不以}或]结尾，猜测是多行
+		timer.Switch(Profiler::ReadPhase);
+		string newString;
+		do
+		{
+			getline(in, newString);
+			inputString += newString;
+		} while (newString != "}" && newString != "]");
+		timer.Switch(Profiler::ParsePhase);
+	}
+#endif
+	const Internals::InputValue &input = Internals::_parseInput(inputString);
+	timer.Switch(Profiler::ReplayPhase);
+
+	if (input.isObject())
+	{
+		const Internals::InputValue &requests = input["requests"], &responses = input["responses"];
+		if (!requests.isNull() && requests.isArray())
+		{
+			size_t i = 0, n = requests.size();
+			outData = input["data"].asString();
+			outGlobalData = input["globaldata"].asString();
+
+			// 如果上回合留下了本局的存档，直接从存档处继续，不再回放整个历史
+			string extra;
+			if (n > 0 && Internals::_restoreCheckpoint(game, outData, requests[0U], n, i, extra))
+				outData.swap(extra);
+			else if (outData.compare(0, 4, Internals::checkpointPrefix) == 0)
+				outData.clear(); // 校验失败的存档，不交给调用者
+
+			// 历史回合不会再被 Revert，因此用不记录 log 的方式快速回放
+			for (; i < n; i++)
+			{
+				if (i > 0)
+					Internals::_processRequestOrResponse(game, responses[(int)i - 1], false, true);
+				Internals::_processRequestOrResponse(game, requests[(int)i], true, true);
+			}
+			return;
+		}
+	}
+	Internals::_processRequestOrResponse(game, input, true);
+}
+
+// 把 game 的当前局面和附加数据 extra 打包成可以放进 data 的存档
+// 下回合重新运行时 ReadInput 会校验并直接恢复局面，并把 extra 作为 data 返回
+// 结果放在每个线程复用的缓冲区中，下次调用前有效
+const string &MakeCheckpoint(const GameContext &game, const string &extra = "")
+{
+	thread_local string binary, encoded;
+	binary.assign(Internals::checkpointMagic, sizeof(Internals::checkpointMagic));
+	binary += (char)(game.processedRequests & 255);
+	binary += (char)(game.processedRequests >> 8 & 255);
+	for (int i = 0; i < 3; i++)
+		Internals::_appendUInt32(binary, game.fieldMasks[i]);
+	game.field->SaveSnapshot(binary);
+	binary += extra;
+	Internals::_appendUInt32(binary, Internals::_checksum(binary.data(), binary.size()));
+	encoded.clear();
+	Internals::_base64Encode(binary, encoded);
+	return encoded;
+}
+
+// 提交决策并退出，下回合时会重新运行程序
+void SubmitAndExit(Action tank0, Action tank1, const string &debug = "", const string &data = "", const string &globalData = "")
+{
+	Internals::_submitAction(tank0, tank1, debug, data, globalData, false);
+	exit(0);
+}
+
+// 提交决策，下回合时程序继续运行（需要在 Botzone 上提交 Bot 时选择“允许长时运行”）
+// 如果游戏结束，程序会被系统杀死
+void SubmitAndDontExit(GameContext &game, Action tank0, Action tank1, const string &debug = "", const string &data = "",
+					   const string &globalData = "")
+{
+	game.field->nextAction[game.field->mySide][0] = tank0;
+	game.field->nextAction[game.field->mySide][1] = tank1;
+	Internals::_submitAction(tank0, tank1, debug, data, globalData, true);
+}
+#ifdef _MSC_VER
+#pragma endregion
+#endif
+
+// 对局记录只在本地使用（Botzone 上不能写文件）
+#ifndef _BOTZONE_ONLINE
+#ifdef _MSC_VER
+#pragma region GameRecord 对局记录
+#endif
+
+// 对局记录文件以 recordFileMagic 开头，之后依次是每局的记录（整数均为小端序）：
+//   3 个 uint32：初始砖块分布（格式与 TankField 的构造函数相同）
+//   1 字节：已经进行的回合数 n（不超过 100）
+//   1 字节：结果（GameResult，NotFinished 表示记录时对局还没有结束）
+//   n * 2 字节：每回合的四个动作，格式与 SaveSnapshot 相同（每个动作 +2 后占 4 位）
+// 一局的记录不超过 214 字节
+const char recordFileMagic[] = {'T', 'K', 'R', 1};
+const size_t recordHeaderSize = 3 * 4 + 2;
+
+// 本地运行的 bot 打开 local_logs 时每回合把本局到目前为止的记录写到这里
+const char *const liveRecordPath = "tank_game.rec";
+
+// 把 field 所在的对局追加到 out 末尾，hasBrick 为这局的初始砖块分布
+void AppendRecord(string &out, const int hasBrick[3], const TankField &field, GameResult result)
+{
+	int turns = std::min(field.currentTurn - 1, 100);
+	for (int i = 0; i < 3; i++)
+		Internals::_appendUInt32(out, hasBrick[i]);
+	out += (char)turns;
+	out += (char)result;
+	for (int turn = 1; turn <= turns; turn++)
+		for (int side = 0; side < sideCount; side++)
+			out += (char)((field.previousActions[turn][side][0] + 2) | (field.previousActions[turn][side][1] + 2) << 4);
+}
+
+// 一局的记录，直接指向 RecordReader 映射的内存，不复制数据
+struct RecordView
+{
+	const unsigned char *data;
+
+	void GetField(int hasBrick[3]) const
+	{
+		for (int i = 0; i < 3; i++)
+			hasBrick[i] = (int)Internals::_readUInt32(data + i * 4);
+	}
+
+	int Turns() const
+	{
+		return data[12];
+	}
+
+	GameResult Result() const
+	{
+		return (GameResult)(signed char)data[13];
+	}
+
+	// 第 turn 回合（从 1 开始）side 方 tank 号坦克的动作
+	Action GetAction(int turn, int side, int tank) const
+	{
+		return (Action)((data[recordHeaderSize + (turn - 1) * sideCount + side] >> (tank * 4) & 15) - 2);
+	}
+
+	size_t Size() const
+	{
+		return recordHeaderSize + Turns() * sideCount;
+	}
+
+	// 在按 GetField 新建的 field 上回放前 turns 个回合，遇到非法动作时返回 false
+	bool Replay(TankField &field, int turns) const
+	{
+		for (int turn = 1; turn <= turns; turn++)
+		{
+			for (int side = 0; side < sideCount; side++)
+				for (int tank = 0; tank < tankPerSide; tank++)
+					field.nextAction[side][tank] = GetAction(turn, side, tank);
+			if (!field.FastForward())
+				return false;
+		}
+		return true;
+	}
+};
+
+// 把对局记录写到文件，先攒在缓冲区中，够大时再一次写入
+class RecordWriter
+{
+  public:
+	// append 为 false 时清空已有的内容
+	explicit RecordWriter(const char *path, bool append = true)
+	{
+		file = fopen(path, append ? "ab" : "wb");
+		if (file && (fseek(file, 0, SEEK_END) != 0 || ftell(file) == 0))
+			buffer.assign(recordFileMagic, sizeof(recordFileMagic));
+	}
+
+	~RecordWriter()
+	{
+		if (file)
+		{
+			Flush();
+			fclose(file);
+		}
+	}
+
+	bool IsOpen() const
+	{
+		return file != nullptr;
+	}
+
+	void Write(const int hasBrick[3], const TankField &field, GameResult result)
+	{
+		AppendRecord(buffer, hasBrick, field, result);
+		if (buffer.size() >= flushSize)
+			Flush();
+	}
+
+	// 写入若干条已经用 AppendRecord 编码好的记录
+	void WriteEncoded(const string &records)
+	{
+		buffer += records;
+		if (buffer.size() >= flushSize)
+			Flush();
+	}
+
+	bool Flush()
+	{
+		if (!file || buffer.empty())
+			return file != nullptr;
+		bool ok = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+		buffer.clear();
+		return ok;
+	}
+
+  private:
+	static const size_t flushSize = 1 << 16;
+	FILE *file;
+	string buffer;
+};
+
+// 用 mmap 把记录文件映射到内存中顺序读取，不复制数据
+class RecordReader
+{
+  public:
+	explicit RecordReader(const char *path)
+	{
+#ifdef _MSC_VER
+		FILE *file = fopen(path, "rb");
+		if (file)
+		{
+			char chunk[1 << 16];
+			size_t size;
+			while ((size = fread(chunk, 1, sizeof(chunk), file)) > 0)
+				contents.append(chunk, size);
+			fclose(file);
+			_setRange((const unsigned char *)contents.data(), contents.size());
+		}
+#else
+		int fd = open(path, O_RDONLY);
+		struct stat info;
+		if (fd >= 0 && fstat(fd, &info) == 0 && info.st_size > 0)
+		{
+			void *address = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (address != MAP_FAILED)
+			{
+				madvise(address, (size_t)info.st_size, MADV_SEQUENTIAL);
+				mapped = address;
+				mappedSize = (size_t)info.st_size;
+				_setRange((const unsigned char *)mapped, mappedSize);
+			}
+		}
+		if (fd >= 0)
+			close(fd);
+#endif
+	}
+
+	~RecordReader()
+	{
+#ifndef _MSC_VER
+		if (mapped)
+			munmap(mapped, mappedSize);
+#endif
+	}
+
+	RecordReader(const RecordReader &) = delete;
+	RecordReader &operator=(const RecordReader &) = delete;
+
+	// 文件能否打开且格式正确
+	bool IsOpen() const
+	{
+		return begin != nullptr;
+	}
+
+	// 读取下一局，没有更多记录（或者最后一条记录不完整）时返回 false
+	bool Next(RecordView &record)
+	{
+		if ((size_t)(end - cursor) < recordHeaderSize)
+			return false;
+		record.data = cursor;
+		if ((size_t)(end - cursor) < record.Size())
+			return false;
+		cursor += record.Size();
+		return true;
+	}
+
+	// 回到第一局
+	void Rewind()
+	{
+		cursor = begin;
+	}
+
+	// 记录部分的字节数（不含文件头）
+	size_t Size() const
+	{
+		return end - begin;
+	}
+
+  private:
+	const unsigned char *begin = nullptr, *end = nullptr, *cursor = nullptr;
+#ifdef _MSC_VER
+	string contents;
+#else
+	void *mapped = nullptr;
+	size_t mappedSize = 0;
+#endif
+
+	void _setRange(const unsigned char *data, size_t size)
+	{
+		if (size < sizeof(recordFileMagic) || memcmp(data, recordFileMagic, sizeof(recordFileMagic)))
+			return;
+		cursor = begin = data + sizeof(recordFileMagic);
+		end = data + size;
+	}
+};
+
+#ifdef _MSC_VER
+#pragma endregion
+#endif
+#endif
+} // namespace TankGame
+
+int RandBetween(int from, int to)
+{
+	return (int)TankGame::threadRandom.Uniform(to - from) + from;
+}
+
+TankGame::Action RandAction(const TankGame::TankField &field, int tank)
+{
+	return field.SampleLegal(field.mySide, tank);
+}
+
+//存档中附带的bot状态：上回合敌方坦克的位置、恢复次数和随机数发生器的状态
+//距离表可以由场地重新算出，不放进存档
+const char bot_state_version = 'C';
+
+void append_uint32(string &out, unsigned int value)
+{
+	for (int i = 0; i < 4; i++)
+		out += (char)(value >> (i * 8) & 255);
+}
+
+unsigned int read_uint32(const unsigned char *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (unsigned int)p[3] << 24;
+}
+
+//一局游戏中一方bot的状态和heuristic的各个函数；与局面有关、双方共用的距离表在GameContext的DistanceCache中
+//每个对象互相独立，一个进程可以同时为多局（多个线程）做决策
+struct BotContext
+{
+	//当前做决策的局面，由Analysis设置
+	const TankGame::TankField *field = nullptr;
+
+	//距离表，由Analysis从这一局共用的DistanceCache中取得
+	const int (*dis)[15][15][15] = nullptr;
+	int attack_distance[15][2] = {};
+	int safty_block[15][15] = {};
+	bool alive[2][2] = {};
+	int enemy_side = 0, my_side = 0;
+	std::pair<int, int> enemy_tank[2], my_tank[2];
+	//记录上一回合敌方坦克的位置，预判它下一回合可能的移动方向
+	std::pair<int, int> last_enemy_tank[2];
+	std::pair<int, int> predict_enemy_tank[2];
+	//从存档恢复的次数，随存档一起保存
+	unsigned int checkpoint_restores = 0;
+
+	bool update_safty(TankGame::FieldItem item, int x, int y, int add)
+	{ //判断一个格子是否可以被坦克火力覆盖到
+		//add=2 被敌方坦克打到 add=3 被我方坦克打到
+		//一个敌方坦克 2 两个敌方坦克 4 一个敌方一个我方 5 一个我方 3
+		switch (item)
+		{
+		case TankGame::None:
+			safty_block[x][y] += add;
+			break;
+		case TankGame::Brick:
+			safty_block[x][y] += add;
+			return 1;
+		case TankGame::Steel:
+			return 1;
+		case TankGame::Base:
+			safty_block[x][y] += add;
+			return 1;
+		default:
+			safty_block[x][y] += add;
+			return 0;
+		}
+		return 0;
+	}
+
+	void update_attack_distance()
+	{
+		TankGame::Profiler::ScopedTimer timer(TankGame::Profiler::AttackPhase);
+		//计算出从第一行直接攻击基地，中间有多少个砖块需要被打掉
+		int cnt[9];
+		memset(cnt, 0, sizeof(cnt));
+		for (int i = 0; i < 9; i++)
+			if (field->gameField[0][i] == TankGame::Brick)
+				cnt[i] = cnt[i - 1] + 1;
+			else
+				cnt[i] = cnt[i - 1];
+		for (int i = 0; i < 9; i++)
+			attack_distance[i][0] = cnt[std::max(i, 4)] - cnt[std::min(i, 4)];
+		//计算出从最后一行直接攻击基地，中间有多少个砖块需要被打掉
+		memset(cnt, 0, sizeof(cnt));
+		for (int i = 0; i < 9; i++)
+			if (field->gameField[8][i] == TankGame::Brick)
+				cnt[i] = cnt[i - 1] + 1;
+			else
+				cnt[i] = cnt[i - 1];
+		for (int i = 0; i < 9; i++)
+			attack_distance[i][1] = cnt[std::max(i, 4)] - cnt[std::min(i, 4)];
+	}
+
+	std::pair<int, int> choose_moving_target(std::pair<int, int> tank_position, int side) const
+	{ //找到从当前位置最快可以打击到对方基地的目标点
+		std::pair<int, int> target;
+		int min_distance = 0x3ff;
+		for (int i = 0; i < 9; i++)
+		{
+			if (dis[tank_position.first][tank_position.second][side ? 0 : 8][i] + attack_distance[i][side ^ 1] * 2 < min_distance)
+			{
+				target = std::make_pair(side ? 0 : 8, i);
+				min_distance = dis[tank_position.first][tank_position.second][side ? 0 : 8][i] + attack_distance[i][side ^ 1] * 2;
+			}
+		}
+		return target;
+	}
+
+	bool judge_right_path(std::pair<int, int> target, std::pair<int, int> tank_position, std::pair<int, int> tmp_point) const
+	{
+		//判断最短路是否经过tmp_point
+		int dis1 = dis[tank_position.first][tank_position.second][tmp_point.first][tmp_point.second];
+		int dis2 = dis[tmp_point.first][tmp_point.second][target.first][target.second];
+		int dis3 = dis[tank_position.first][tank_position.second][target.first][target.second];
+		return (dis1 + dis2) == dis3;
+	}
+
+	void find_enemy_move(int tank)
+	{
+		//预判地方坦克的运动方向
+		//第一：假设对方会朝着原来的运动方向运动
+		int abs_i = enemy_tank[tank].first - last_enemy_tank[tank].first;
+		int abs_j = enemy_tank[tank].second - last_enemy_tank[tank].second;
+		predict_enemy_tank[tank].first = enemy_tank[tank].first + abs_i;
+		predict_enemy_tank[tank].second = enemy_tank[tank].second + abs_j;
+		if (field->gameField[predict_enemy_tank[tank].first][predict_enemy_tank[tank].second] == TankGame::None)
+			return;
+		//如果预测出的点不可达的话，假设对方坦克将会走最短能打击到我方基地的路线
+		predict_enemy_tank[tank] = choose_moving_target(enemy_tank[tank], enemy_side);
+		for (int k = 0; k < 4; k++)
+		{
+			int tmpy = enemy_tank[tank].first + TankGame::dy[k], tmpx = enemy_tank[tank].second + TankGame::dx[k];
+			if (!TankGame::CoordValid(tmpx, tmpy))
+				continue;
+			if (field->gameField[tmpy][tmpx] == TankGame::Steel)
+				continue;
+			if (field->gameField[tmpy][tmpx] != TankGame::Brick)
+			{
+				if (judge_right_path(predict_enemy_tank[tank], enemy_tank[tank], std::make_pair(tmpy, tmpx)))
+				{
+					predict_enemy_tank[tank] = std::make_pair(tmpy, tmpx);
+					return;
+				}
+			}
+		}
+		predict_enemy_tank[tank] = enemy_tank[tank];
+	}
+
+	void update_alive()
+	{
+		//预处理出每回合坦克的存活情况，防止带来误判
+		if (enemy_tank[0].first == -1)
+			alive[enemy_side][0] = 0;
+		else
+			alive[enemy_side][0] = 1;
+		if (enemy_tank[1].first == -1)
+			alive[enemy_side][1] = 0;
+		else
+			alive[enemy_side][1] = 1;
+		if (my_tank[0].first == -1)
+			alive[enemy_side ^ 1][0] = 0;
+		else
+			alive[enemy_side ^ 1][0] = 1;
+		if (my_tank[1].first == -1)
+			alive[enemy_side ^ 1][1] = 0;
+		else
+			alive[enemy_side ^ 1][1] = 1;
+	}
+
+	void update_positions(int side)
+	{
+		//更新对方坦克和自己坦克的坐标，side为做决策的一方
+		enemy_side = side ^ 1;
+		my_side = side;
+		enemy_tank[0] = std::make_pair(field->tankY[enemy_side][0], field->tankX[enemy_side][0]);
+		enemy_tank[1] = std::make_pair(field->tankY[enemy_side][1], field->tankX[enemy_side][1]);
+		my_tank[0] = std::make_pair(field->tankY[my_side][0], field->tankX[my_side][0]);
+		my_tank[1] = std::make_pair(field->tankY[my_side][1], field->tankX[my_side][1]);
+		update_alive();
+	}
+
+	void update_threat()
+	{
+		//需要先算好距离表和attack_distance
+		TankGame::Profiler::ScopedTimer timer(TankGame::Profiler::ThreatPhase);
+		memset(safty_block, 0, sizeof(safty_block));
+		//预测对方的移动方向
+		if (alive[enemy_side][0])
+			find_enemy_move(0);
+		else
+			predict_enemy_tank[0] = enemy_tank[0];
+		if (alive[enemy_side][1])
+			find_enemy_move(1);
+		else
+			predict_enemy_tank[1] = enemy_tank[1];
+		//预处理出对方坦克的火力范围和我方坦克的火力范围
+		//2为敌人火力，3为我方火力
+		for (int j = 0; j < 2; j++)
+		{
+			if (!alive[enemy_side][j])
+				continue;
+			if (!field->ActionIsValid(enemy_side, j, TankGame::LeftShoot))
+				continue;
+			for (int i = enemy_tank[j].first + 1; i < 9; i++)
+				if (update_safty(field->gameField[i][enemy_tank[j].second], i, enemy_tank[j].second, 2))
+					break;
+
+			for (int i = enemy_tank[j].first - 1; i >= 0; i--)
+				if (update_safty(field->gameField[i][enemy_tank[j].second], i, enemy_tank[j].second, 2))
+					break;
+
+			for (int i = enemy_tank[j].second + 1; i < 9; i++)
+				if (update_safty(field->gameField[enemy_tank[j].first][i], enemy_tank[j].first, i, 2))
+					break;
+
+			for (int i = enemy_tank[j].second - 1; i >= 0; i--)
+				if (update_safty(field->gameField[enemy_tank[j].first][i], enemy_tank[j].first, i, 2))
+					break;
+		}
+		for (int j = 0; j < 2; j++)
+		{
+			if (!alive[enemy_side ^ 1][j])
+				continue;
+			if (!field->ActionIsValid(my_side, j, TankGame::LeftShoot))
+				continue;
+			for (int i = my_tank[j].first + 1; i < 9; i++)
+				if (update_safty(field->gameField[i][my_tank[j].second], i, my_tank[j].second, 3))
+					break;
+
+			for (int i = my_tank[j].first - 1; i >= 0; i--)
+				if (update_safty(field->gameField[i][my_tank[j].second], i, my_tank[j].second, 3))
+					break;
+
+			for (int i = my_tank[j].second + 1; i < 9; i++)
+				if (update_safty(field->gameField[my_tank[j].first][i], my_tank[j].first, i, 3))
+					break;
+
+			for (int i = my_tank[j].second - 1; i >= 0; i--)
+				if (update_safty(field->gameField[my_tank[j].first][i], my_tank[j].first, i, 3))
+					break;
+		}
+	}
+
+	void update_info(TankGame::DistanceCache &distances, int side)
+	{
+		//一次算好heuristic需要的全部信息
+		update_positions(side);
+		dis = distances.Get(*field);
+		update_attack_distance();
+		update_threat();
+	}
+
+	TankGame::Action choose_move_direction(int x) const
+	{
+		//找到移动方向
+		if (x == 0)
+			return TankGame::Up;
+		else if (x == 1)
+			return TankGame::Right;
+		else if (x == 2)
+			return TankGame::Down;
+		else
+			return TankGame::Left;
+	}
+
+	TankGame::Action choose_shoot_direction(int side, int tank, int x) const
+	{
+		if (x == 0)
+			return field->ActionIsValid(side, tank, TankGame::UpShoot) ? TankGame::UpShoot : TankGame::Stay;
+		else if (x == 1)
+			return field->ActionIsValid(side, tank, TankGame::RightShoot) ? TankGame::RightShoot : TankGame::Stay;
+		else if (x == 2)
+			return field->ActionIsValid(side, tank, TankGame::DownShoot) ? TankGame::DownShoot : TankGame::Stay;
+		else
+			return field->ActionIsValid(side, tank, TankGame::LeftShoot) ? TankGame::LeftShoot : TankGame::Stay;
+	}
+
+	TankGame::Action check_brick_between_two_tank(std::pair<int, int> my_tank, std::pair<int, int> enemy_tank) const
+	{
+		//查看两个坦克之间是否可以直接进行攻击
+		//如果在同一行
+		if (my_tank.first == enemy_tank.first)
+		{
+			if (my_tank.second < enemy_tank.second)
+				return TankGame::RightShoot;
+			else
+				return TankGame::LeftShoot;
+		}
+		//如果在同一列
+		if (my_tank.second == enemy_tank.second)
+		{
+			if (my_tank.first < enemy_tank.first)
+				return TankGame::DownShoot;
+			else
+				return TankGame::UpShoot;
+		}
+		return TankGame::Invalid;
+	}
+
+	bool is_none_between_two_point(std::pair<int, int> a, std::pair<int, int> b) const
+	{
+		if (check_brick_between_two_tank(a, b) == TankGame::Invalid)
+			return 0;
+		if (a.first == b.first)
+		{
+			for (int i = std::min(a.second, b.second) + 1; i < std::max(a.second, b.second); i++)
+				if (field->gameField[a.first][i] != TankGame::None)
+					return 0;
+		}
+		else
+		{
+			for (int i = std::min(a.first, b.first) + 1; i < std::max(a.first, b.first); i++)
+				if (field->gameField[i][a.second] != TankGame::None)
+					return 0;
+		}
 		return 1;
-	case TankGame::Steel:
+	}
+
+	TankGame::Action attack(int side, int tank) const
+	{
+		//对于敌方的第一个坦克的当前位置
+		if ((safty_block[enemy_tank[0].first][enemy_tank[0].second] == 3 || safty_block[enemy_tank[0].first][enemy_tank[0].second] > 4) && alive[enemy_side][0] && is_none_between_two_point(enemy_tank[0], my_tank[tank]))
+			return check_brick_between_two_tank(my_tank[tank], enemy_tank[0]);
+		//对于敌方的第二个坦克的当前位置
+		if ((safty_block[enemy_tank[1].first][enemy_tank[1].second] == 3 || safty_block[enemy_tank[1].first][enemy_tank[1].second] > 4) && alive[enemy_side][1] && is_none_between_two_point(enemy_tank[1], my_tank[tank]))
+			return check_brick_between_two_tank(my_tank[tank], enemy_tank[1]);
+		//对于敌方的第一个坦克的预测位置
+		if ((safty_block[predict_enemy_tank[0].first][predict_enemy_tank[0].second] == 3 || safty_block[predict_enemy_tank[0].first][predict_enemy_tank[0].second] > 4) && alive[enemy_side][0] && is_none_between_two_point(predict_enemy_tank[0], my_tank[tank]))
+			return check_brick_between_two_tank(my_tank[tank], predict_enemy_tank[0]);
+		//对于敌方的第二个坦克的预测位置
+		if ((safty_block[predict_enemy_tank[1].first][predict_enemy_tank[1].second] == 3 || safty_block[predict_enemy_tank[1].first][predict_enemy_tank[1].second] > 4) && alive[enemy_side][1] && is_none_between_two_point(predict_enemy_tank[1], my_tank[tank]))
+			return check_brick_between_two_tank(my_tank[tank], predict_enemy_tank[1]);
+		return TankGame::Invalid;
+	}
+
+	bool is_position_safe(std::pair<int, int> pos) const
+	{
+		//2 1个敌方坦克
+		//4 2个敌方坦克
+		//5 1个敌方坦克 1个我方坦克
+		//7 2敌方 1我方
+		//8 1敌方 2我方
+		//10 2敌方 2我方
+		if (safty_block[pos.first][pos.second] == 2)
+			return 0;
+		if (safty_block[pos.first][pos.second] == 4)
+			return 0;
+		if (safty_block[pos.first][pos.second] == 5)
+			return 0;
+		if (safty_block[pos.first][pos.second] == 7)
+			return 0;
+		if (safty_block[pos.first][pos.second] == 8)
+			return 0;
+		if (safty_block[pos.first][pos.second] == 10)
+			return 0;
 		return 1;
-	case TankGame::Base:
-		safty_block[x][y] += add;
+	}
+
+	bool is_position_safe_pro(std::pair<int, int> pos, std::pair<int, int> my_tank) const
+	{
+		//对于发射炮弹进行判断
+		//只需要判断发射炮弹之后是否会使对方可以打到我方坦克
+		//既需要判断对方坦克现在的位置，也要考虑预测出来的移动方向
+		int abs_i = pos.first - my_tank.first;
+		int abs_j = pos.second - my_tank.second;
+		std::pair<int, int> tmp = pos;
+		tmp.first += abs_i;
+		tmp.second += abs_j;
+		while (TankGame::CoordValid(tmp.first, tmp.second))
+		{
+			if (tmp == enemy_tank[0])
+				return 0;
+			if (tmp == enemy_tank[1])
+				return 0;
+			//防止我方开了墙之后，对手正好移动过来，然后gg的局面
+			for (int k = 0; k < 4; k++)
+			{
+				int tmpy = tmp.first + TankGame::dy[k], tmpx = tmp.second + TankGame::dx[k];
+				std::pair<int, int> next_position = std::make_pair(tmpy, tmpx);
+				if (next_position == enemy_tank[0])
+					return 0;
+				if (next_position == enemy_tank[1])
+					return 0;
+			}
+			if (field->gameField[tmp.first][tmp.second] != TankGame::None)
+				return 1;
+			tmp.first += abs_i;
+			tmp.second += abs_j;
+		}
 		return 1;
-	default:
-		safty_block[x][y] += add;
-		return 0;
 	}
-	return 0;
-}
 
-void update_distance()
-{ //用Floyd算出任意两点之间的距离（需要走的回合数）
-	for (int i = 0; i < TankGame::fieldHeight; i++)
-		for (int j = 0; j < TankGame::fieldWidth; j++)
+	TankGame::Action Final_Action(int side, int tank, std::pair<int, int> tank_position) const
+	{ //当坦克到达底线，战斗即将结束
+		//需要判断是否会被对手打到
+		if (!is_position_safe(tank_position))
+		{
+			//如果会被打到，试着左右走位
+			for (int k = 0; k < 4; k++)
+				if (k % 2 == 1)
+				{
+					int tmpy = tank_position.first + TankGame::dy[k], tmpx = tank_position.second + TankGame::dx[k];
+					if (!TankGame::CoordValid(tmpx, tmpy))
+						continue;
+					if (field->gameField[tmpy][tmpx] == TankGame::Steel)
+						continue;
+					if (!is_position_safe(std::make_pair(tmpy, tmpx)))
+						continue;
+					if (field->gameField[tmpy][tmpx] == TankGame::None)
+					{
+						return choose_move_direction(k);
+					}
+				}
+			//否则确保自身安全，朝对手坦克开炮
+			if (tank_position.second < 4)
+			{
+				for (int i = tank_position.second + 1; i <= 4; i++)
+					if (field->gameField[tank_position.first][i] == TankGame::Base)
+						return field->ActionIsValid(side, tank, TankGame::RightShoot) ? TankGame::RightShoot : TankGame::Stay;
+					else if (field->gameField[tank_position.first][i] != TankGame::None)
+						break;
+			}
+			else
+			{
+				for (int i = tank_position.second - 1; i >= 4; i--)
+					if (field->gameField[tank_position.first][i] == TankGame::Base)
+						return field->ActionIsValid(side, tank, TankGame::LeftShoot) ? TankGame::LeftShoot : TankGame::Stay;
+					else if (field->gameField[tank_position.first][i] != TankGame::None)
+						break;
+			}
+			if (field->ActionIsValid(side, tank, TankGame::LeftShoot))
+			{ //检测是否可以进行攻击
+				TankGame::Action rec = attack(side, tank);
+				if (rec != TankGame::Invalid)
+					return rec;
+			}
+		}
+		if (tank_position.second < 4)
+		{
+			return field->ActionIsValid(side, tank, TankGame::RightShoot) ? TankGame::RightShoot : TankGame::Stay;
+		}
+		else
+		{
+			return field->ActionIsValid(side, tank, TankGame::LeftShoot) ? TankGame::LeftShoot : TankGame::Stay;
+		}
+	}
+
+	TankGame::Action continue_life(std::pair<int, int> my_position, std::pair<int, int> target) const
+	{
+		//续一秒！
+		int max_dis = dis[my_position.first][my_position.second][target.first][target.second], move_id = -1;
+		for (int k = 0; k < 4; k++)
+		{
+			int tmpy = my_position.first + TankGame::dy[k], tmpx = my_position.second + TankGame::dx[k];
+			if (!TankGame::CoordValid(tmpx, tmpy))
+				continue;
+			if (field->gameField[tmpy][tmpx] == TankGame::Steel)
+				continue;
+			if (!is_position_safe(std::make_pair(tmpy, tmpx)))
+				continue;
+			if (field->gameField[tmpy][tmpx] == TankGame::None)
+			{
+				if (dis[tmpy][tmpx][target.first][target.second] <= max_dis)
+				{
+					max_dis = dis[tmpy][tmpx][target.first][target.second];
+					move_id = k;
+				}
+			}
+		}
+		if (move_id != -1)
+			return choose_move_direction(move_id);
+		else
+			return TankGame::Invalid;
+	}
+
+	TankGame::Action MyAction(int side, int tank) const
+	{
+		//判断坦克是否存活
+		if (my_tank[tank].first == -1)
+			return TankGame::Stay;
+		std::pair<int, int> tank_position = my_tank[tank];
+		std::pair<int, int> target = choose_moving_target(tank_position, my_side);
+		if (target == tank_position)
+		{ //说明坦克已经到达最后目标，只需要朝着对方基地射击即可
+			return Final_Action(side, tank, tank_position);
+		}
+		else
 		{
-			dis[i][j][i][j] = 0;
+			//先找是否可以直接进行移动，而不需要发射炮弹（即有多条道路）
+			for (int k = 0; k < 4; k++)
+			{
+				int tmpy = tank_position.first + TankGame::dy[k], tmpx = tank_position.second + TankGame::dx[k];
+				if (!TankGame::CoordValid(tmpx, tmpy))
+					continue;
+				if (field->gameField[tmpy][tmpx] == TankGame::Steel)
+					continue;
+				if (!is_position_safe(std::make_pair(tmpy, tmpx)))
+					continue;
+				if (field->gameField[tmpy][tmpx] == TankGame::None)
+				{
+					if (judge_right_path(target, tank_position, std::make_pair(tmpy, tmpx)))
+						return choose_move_direction(k);
+				}
+			}
+			//如果当前格子是危险的,朝四周躲避
+			if (!is_position_safe(tank_position))
+			{
+				TankGame::Action rec = continue_life(tank_position, target);
+				if (rec != TankGame::Invalid)
+					return rec;
+			}
+			if (field->ActionIsValid(side, tank, TankGame::LeftShoot))
+			{ //检测是否可以进行攻击
+				TankGame::Action rec = attack(side, tank);
+				if (rec != TankGame::Invalid)
+					return rec;
+			}
+			//否则发射炮弹开路
 			for (int k = 0; k < 4; k++)
 			{
-				int tmpy = i + TankGame::dy[k], tmpx = j + TankGame::dx[k];
+				int tmpy = tank_position.first + TankGame::dy[k], tmpx = tank_position.second + TankGame::dx[k];
 				if (!TankGame::CoordValid(tmpx, tmpy))
 					continue;
-				if (TankGame::field->gameField[tmpy][tmpx] == TankGame::Steel)
+				if (field->gameField[tmpy][tmpx] == TankGame::Steel)
 					continue;
-				if (TankGame::field->gameField[tmpy][tmpx] == TankGame::Brick)
-					dis[i][j][tmpy][tmpx] = 2; //砖块需要两个回合
-				else
-					dis[i][j][tmpy][tmpx] = 1; //其他需要一个回合
+				if (!is_position_safe_pro(std::make_pair(tmpy, tmpx), tank_position))
+					continue;
+				if (field->gameField[tmpy][tmpx] == TankGame::Brick)
+				{
+					if (judge_right_path(target, tank_position, std::make_pair(tmpy, tmpx)))
+						return choose_shoot_direction(side, tank, k);
+				}
 			}
 		}
-	//Floyd
-	for (int ki = 0; ki < TankGame::fieldHeight; ki++)
-		for (int kj = 0; kj < TankGame::fieldWidth; kj++)
-			for (int i = 0; i < TankGame::fieldHeight; i++)
-				for (int j = 0; j < TankGame::fieldWidth; j++)
-					for (int ii = 0; ii < TankGame::fieldHeight; ii++)
-						for (int jj = 0; jj < TankGame::fieldWidth; jj++)
-							dis[i][j][ii][jj] = std::min(dis[i][j][ii][jj], dis[i][j][ki][kj] + dis[ki][kj][ii][jj]);
-}
-
-void update_attack_distance()
-{
-	//计算出从第一行直接攻击基地，中间有多少个砖块需要被打掉
-	int cnt[9];
-	memset(cnt, 0, sizeof(cnt));
-	for (int i = 0; i < 9; i++)
-		if (TankGame::field->gameField[0][i] == TankGame::Brick)
-			cnt[i] = cnt[i - 1] + 1;
-		else
-			cnt[i] = cnt[i - 1];
-	for (int i = 0; i < 9; i++)
-		attack_distance[i][0] = cnt[std::max(i, 4)] - cnt[std::min(i, 4)];
-	//计算出从最后一行直接攻击基地，中间有多少个砖块需要被打掉
-	memset(cnt, 0, sizeof(cnt));
-	for (int i = 0; i < 9; i++)
-		if (TankGame::field->gameField[8][i] == TankGame::Brick)
-			cnt[i] = cnt[i - 1] + 1;
-		else
-			cnt[i] = cnt[i - 1];
-	for (int i = 0; i < 9; i++)
-		attack_distance[i][1] = cnt[std::max(i, 4)] - cnt[std::min(i, 4)];
-}
+		return TankGame::Stay;
+	}
 
-std::pair<int, int> choose_moving_target(std::pair<int, int> tank_position, int side)
-{ //找到从当前位置最快可以打击到对方基地的目标点
-	std::pair<int, int> target;
-	int min_distance = 0x3ff;
-	for (int i = 0; i < 9; i++)
+	//把状态写到out中（覆盖原有内容），out可以每回合复用
+	void save_bot_state(string &out) const
 	{
-		if (dis[tank_position.first][tank_position.second][side ? 0 : 8][i] + attack_distance[i][side ^ 1] * 2 < min_distance)
+		out.assign(1, bot_state_version);
+		for (int tank = 0; tank < 2; tank++)
+		{
+			out += (char)last_enemy_tank[tank].first;
+			out += (char)last_enemy_tank[tank].second;
+		}
+		append_uint32(out, checkpoint_restores);
+		unsigned long long random_state[4];
+		TankGame::threadRandom.GetState(random_state);
+		for (int i = 0; i < 4; i++)
 		{
-			target = std::make_pair(side ? 0 : 8, i);
-			min_distance = dis[tank_position.first][tank_position.second][side ? 0 : 8][i] + attack_distance[i][side ^ 1] * 2;
+			append_uint32(out, (unsigned int)random_state[i]);
+			append_uint32(out, (unsigned int)(random_state[i] >> 32));
 		}
 	}
-	return target;
-}
 
-bool judge_right_path(std::pair<int, int> target, std::pair<int, int> tank_position, std::pair<int, int> tmp_point)
-{
-	//判断最短路是否经过tmp_point
-	int dis1 = dis[tank_position.first][tank_position.second][tmp_point.first][tmp_point.second];
-	int dis2 = dis[tmp_point.first][tmp_point.second][target.first][target.second];
-	int dis3 = dis[tank_position.first][tank_position.second][target.first][target.second];
-	return (dis1 + dis2) == dis3;
-}
+	bool load_bot_state(const string &state)
+	{
+		const size_t state_size = 1 + 2 * 2 + 4 + 4 * 8;
+		const unsigned char *p = (const unsigned char *)state.data();
+		if (state.size() != state_size || p[0] != bot_state_version)
+			return 0;
+		p++;
+		for (int tank = 0; tank < 2; tank++, p += 2)
+			last_enemy_tank[tank] = std::make_pair((int)(signed char)p[0], (int)(signed char)p[1]);
+		checkpoint_restores = read_uint32(p) + 1;
+		p += 4;
+		unsigned long long random_state[4];
+		for (int i = 0; i < 4; i++, p += 8)
+			random_state[i] = read_uint32(p) | (unsigned long long)read_uint32(p + 4) << 32;
+		TankGame::threadRandom.SetState(random_state);
+		return 1;
+	}
 
-void find_enemy_move(int tank)
-{
-	//预判地方坦克的运动方向
-	//第一：假设对方会朝着原来的运动方向运动
-	int abs_i = enemy_tank[tank].first - last_enemy_tank[tank].first;
-	int abs_j = enemy_tank[tank].second - last_enemy_tank[tank].second;
-	predict_enemy_tank[tank].first = enemy_tank[tank].first + abs_i;
-	predict_enemy_tank[tank].second = enemy_tank[tank].second + abs_j;
-	if (TankGame::field->gameField[predict_enemy_tank[tank].first][predict_enemy_tank[tank].second] == TankGame::None)
-		return;
-	//如果预测出的点不可达的话，假设对方坦克将会走最短能打击到我方基地的路线
-	predict_enemy_tank[tank] = choose_moving_target(enemy_tank[tank], enemy_side);
-	for (int k = 0; k < 4; k++)
+	//开始新的一局前清空上一局留下的状态
+	void reset_bot_state()
 	{
-		int tmpy = enemy_tank[tank].first + TankGame::dy[k], tmpx = enemy_tank[tank].second + TankGame::dx[k];
-		if (!TankGame::CoordValid(tmpx, tmpy))
-			continue;
-		if (TankGame::field->gameField[tmpy][tmpx] == TankGame::Steel)
-			continue;
-		if (TankGame::field->gameField[tmpy][tmpx] != TankGame::Brick)
-		{
-			if (judge_right_path(predict_enemy_tank[tank], enemy_tank[tank], std::make_pair(tmpy, tmpx)))
-			{
-				predict_enemy_tank[tank] = std::make_pair(tmpy, tmpx);
-				return;
-			}
-		}
+		last_enemy_tank[0] = last_enemy_tank[1] = std::make_pair(0, 0);
+		checkpoint_restores = 0;
 	}
-	predict_enemy_tank[tank] = enemy_tank[tank];
-}
+};
 
-void update_alive()
+//一回合中某一方（side）视角下对局面的分析，供各个策略共用，构造之后只能读取，不会修改局面
+//坐标、存活情况在构造时算好；距离表、attack_distance、火力范围和对敌方坦克的预测在第一次用到时才计算
+//计算结果存放在bot的BotContext中，因此同一个BotContext同一时间只能有一个Analysis在使用
+class Analysis
 {
-	//预处理出每回合坦克的存活情况，防止带来误判
-	if (enemy_tank[0].first == -1)
-		alive[enemy_side][0] = 0;
-	else
-		alive[enemy_side][0] = 1;
-	if (enemy_tank[1].first == -1)
-		alive[enemy_side][1] = 0;
-	else
-		alive[enemy_side][1] = 1;
-	if (my_tank[0].first == -1)
-		alive[enemy_side ^ 1][0] = 0;
-	else
-		alive[enemy_side ^ 1][0] = 1;
-	if (my_tank[1].first == -1)
-		alive[enemy_side ^ 1][1] = 0;
-	else
-		alive[enemy_side ^ 1][1] = 1;
-}
-
-void update_info()
-{
-	//更新对方坦克和自己坦克的坐标，以及distance的初始化
-	enemy_side = TankGame::field->mySide ^ 1;
-	my_side = TankGame::field->mySide;
-	enemy_tank[0] = std::make_pair(TankGame::field->tankY[enemy_side][0], TankGame::field->tankX[enemy_side][0]);
-	enemy_tank[1] = std::make_pair(TankGame::field->tankY[enemy_side][1], TankGame::field->tankX[enemy_side][1]);
-	my_tank[0] = std::make_pair(TankGame::field->tankY[my_side][0], TankGame::field->tankX[my_side][0]);
-	my_tank[1] = std::make_pair(TankGame::field->tankY[my_side][1], TankGame::field->tankX[my_side][1]);
-	update_alive();
-	memset(dis, 0x3f, sizeof(dis));
-	memset(safty_block, 0, sizeof(safty_block));
-	update_distance();
-	update_attack_distance();
-	//预测对方的移动方向
-	if (alive[enemy_side][0])
-		find_enemy_move(0);
-	else
-		predict_enemy_tank[0] = enemy_tank[0];
-	if (alive[enemy_side][1])
-		find_enemy_move(1);
-	else
-		predict_enemy_tank[1] = enemy_tank[1];
-	//预处理出对方坦克的火力范围和我方坦克的火力范围
-	//2为敌人火力，3为我方火力
-	for (int j = 0; j < 2; j++)
+  public:
+	//bot.last_enemy_tank是上一回合做决策时敌方坦克的位置，用于预测敌方的移动
+	//distances为这一局共用的距离表缓存
+	Analysis(BotContext &bot, TankGame::DistanceCache &distances, const TankGame::TankField &field, int side)
+		: bot(bot), distances(distances), field(field), side(side)
 	{
-		if (!alive[enemy_side][j])
-			continue;
-		if (!TankGame::field->ActionIsValid(enemy_side, j, TankGame::LeftShoot))
-			continue;
-		for (int i = enemy_tank[j].first + 1; i < 9; i++)
-			if (update_safty(TankGame::field->gameField[i][enemy_tank[j].second], i, enemy_tank[j].second, 2))
-				break;
-
-		for (int i = enemy_tank[j].first - 1; i >= 0; i--)
-			if (update_safty(TankGame::field->gameField[i][enemy_tank[j].second], i, enemy_tank[j].second, 2))
-				break;
-
-		for (int i = enemy_tank[j].second + 1; i < 9; i++)
-			if (update_safty(TankGame::field->gameField[enemy_tank[j].first][i], enemy_tank[j].first, i, 2))
-				break;
-
-		for (int i = enemy_tank[j].second - 1; i >= 0; i--)
-			if (update_safty(TankGame::field->gameField[enemy_tank[j].first][i], enemy_tank[j].first, i, 2))
-				break;
+		bot.field = &field;
+		bot.update_positions(side);
 	}
-	for (int j = 0; j < 2; j++)
-	{
-		if (!alive[enemy_side ^ 1][j])
-			continue;
-		if (!TankGame::field->ActionIsValid(TankGame::field->mySide, j, TankGame::LeftShoot))
-			continue;
-		for (int i = my_tank[j].first + 1; i < 9; i++)
-			if (update_safty(TankGame::field->gameField[i][my_tank[j].second], i, my_tank[j].second, 3))
-				break;
 
-		for (int i = my_tank[j].first - 1; i >= 0; i--)
-			if (update_safty(TankGame::field->gameField[i][my_tank[j].second], i, my_tank[j].second, 3))
-				break;
+	//heuristic的各个函数直接读取bot中的表，调用它们之前先RequireAll
+	const BotContext &Bot() const
+	{
+		return bot;
+	}
 
-		for (int i = my_tank[j].second + 1; i < 9; i++)
-			if (update_safty(TankGame::field->gameField[my_tank[j].first][i], my_tank[j].first, i, 3))
-				break;
+	const TankGame::TankField &Field() const
+	{
+		return field;
+	}
 
-		for (int i = my_tank[j].second - 1; i >= 0; i--)
-			if (update_safty(TankGame::field->gameField[my_tank[j].first][i], my_tank[j].first, i, 3))
-				break;
+	int Side() const
+	{
+		return side;
 	}
-}
 
-TankGame::Action choose_move_direction(int x)
-{
-	//找到移动方向
-	if (x == 0)
-		return TankGame::Up;
-	else if (x == 1)
-		return TankGame::Right;
-	else if (x == 2)
-		return TankGame::Down;
-	else
-		return TankGame::Left;
-}
+	//坦克的位置（行, 列），已炸的坦克为(-1, -1)
+	std::pair<int, int> MyTank(int tank) const
+	{
+		return bot.my_tank[tank];
+	}
 
-TankGame::Action choose_shoot_direction(int side, int tank, int x)
-{
-	if (x == 0)
-		return TankGame::field->ActionIsValid(side, tank, TankGame::UpShoot) ? TankGame::UpShoot : TankGame::Stay;
-	else if (x == 1)
-		return TankGame::field->ActionIsValid(side, tank, TankGame::RightShoot) ? TankGame::RightShoot : TankGame::Stay;
-	else if (x == 2)
-		return TankGame::field->ActionIsValid(side, tank, TankGame::DownShoot) ? TankGame::DownShoot : TankGame::Stay;
-	else
-		return TankGame::field->ActionIsValid(side, tank, TankGame::LeftShoot) ? TankGame::LeftShoot : TankGame::Stay;
-}
+	std::pair<int, int> EnemyTank(int tank) const
+	{
+		return bot.enemy_tank[tank];
+	}
 
-TankGame::Action check_brick_between_two_tank(std::pair<int, int> my_tank, std::pair<int, int> enemy_tank)
-{
-	//查看两个坦克之间是否可以直接进行攻击
-	//如果在同一行
-	if (my_tank.first == enemy_tank.first)
+	//从from走到to需要的回合数（打掉砖块算两回合）
+	int Distance(std::pair<int, int> from, std::pair<int, int> to) const
 	{
-		if (my_tank.second < enemy_tank.second)
-			return TankGame::RightShoot;
-		else
-			return TankGame::LeftShoot;
+		_requireDistance();
+		return bot.dis[from.first][from.second][to.first][to.second];
 	}
-	//如果在同一列
-	if (my_tank.second == enemy_tank.second)
+
+	//位于side方坦克从tank出发，走到能打击对方基地的位置并打掉中间的砖块需要的回合数（与choose_moving_target的标准相同）
+	int AttackCost(std::pair<int, int> tank, int side) const
 	{
-		if (my_tank.first < enemy_tank.first)
-			return TankGame::DownShoot;
-		else
-			return TankGame::UpShoot;
+		_requireAttack();
+		std::pair<int, int> target = bot.choose_moving_target(tank, side);
+		return bot.dis[tank.first][tank.second][target.first][target.second] + bot.attack_distance[target.second][side ^ 1] * 2;
 	}
-	return TankGame::Invalid;
-}
 
-bool is_none_between_two_point(std::pair<int, int> a, std::pair<int, int> b)
-{
-	if (check_brick_between_two_tank(a, b) == TankGame::Invalid)
-		return 0;
-	if (a.first == b.first)
+	//格子pos被哪些坦克的火力覆盖（safty_block的值）
+	int Threat(std::pair<int, int> pos) const
 	{
-		for (int i = std::min(a.second, b.second) + 1; i < std::max(a.second, b.second); i++)
-			if (TankGame::field->gameField[a.first][i] != TankGame::None)
-				return 0;
+		_requireThreat();
+		return bot.safty_block[pos.first][pos.second];
 	}
-	else
+
+	//预测的敌方坦克下一回合的位置
+	std::pair<int, int> PredictedEnemyTank(int tank) const
 	{
-		for (int i = std::min(a.first, b.first) + 1; i < std::max(a.first, b.first); i++)
-			if (TankGame::field->gameField[i][a.second] != TankGame::None)
-				return 0;
+		_requireThreat();
+		return bot.predict_enemy_tank[tank];
 	}
-	return 1;
-}
 
-TankGame::Action attack(int side, int tank)
-{
-	//对于敌方的第一个坦克的当前位置
-	if ((safty_block[enemy_tank[0].first][enemy_tank[0].second] == 3 || safty_block[enemy_tank[0].first][enemy_tank[0].second] > 4) && alive[enemy_side][0] && is_none_between_two_point(enemy_tank[0], my_tank[tank]))
-		return check_brick_between_two_tank(my_tank[tank], enemy_tank[0]);
-	//对于敌方的第二个坦克的当前位置
-	if ((safty_block[enemy_tank[1].first][enemy_tank[1].second] == 3 || safty_block[enemy_tank[1].first][enemy_tank[1].second] > 4) && alive[enemy_side][1] && is_none_between_two_point(enemy_tank[1], my_tank[tank]))
-		return check_brick_between_two_tank(my_tank[tank], enemy_tank[1]);
-	//对于敌方的第一个坦克的预测位置
-	if ((safty_block[predict_enemy_tank[0].first][predict_enemy_tank[0].second] == 3 || safty_block[predict_enemy_tank[0].first][predict_enemy_tank[0].second] > 4) && alive[enemy_side][0] && is_none_between_two_point(predict_enemy_tank[0], my_tank[tank]))
-		return check_brick_between_two_tank(my_tank[tank], predict_enemy_tank[0]);
-	//对于敌方的第二个坦克的预测位置
-	if ((safty_block[predict_enemy_tank[1].first][predict_enemy_tank[1].second] == 3 || safty_block[predict_enemy_tank[1].first][predict_enemy_tank[1].second] > 4) && alive[enemy_side][1] && is_none_between_two_point(predict_enemy_tank[1], my_tank[tank]))
-		return check_brick_between_two_tank(my_tank[tank], predict_enemy_tank[1]);
-	return TankGame::Invalid;
-}
+	//算好全部分析
+	void RequireAll() const
+	{
+		_requireThreat();
+	}
 
-bool is_position_safe(std::pair<int, int> pos)
-{
-	//2 1个敌方坦克
-	//4 2个敌方坦克
-	//5 1个敌方坦克 1个我方坦克
-	//7 2敌方 1我方
-	//8 1敌方 2我方
-	//10 2敌方 2我方
-	if (safty_block[pos.first][pos.second] == 2)
-		return 0;
-	if (safty_block[pos.first][pos.second] == 4)
-		return 0;
-	if (safty_block[pos.first][pos.second] == 5)
-		return 0;
-	if (safty_block[pos.first][pos.second] == 7)
-		return 0;
-	if (safty_block[pos.first][pos.second] == 8)
-		return 0;
-	if (safty_block[pos.first][pos.second] == 10)
-		return 0;
-	return 1;
-}
+  private:
+	BotContext &bot;
+	TankGame::DistanceCache &distances;
+	const TankGame::TankField &field;
+	const int side;
+	mutable bool has_distance = false, has_attack = false, has_threat = false;
 
-bool is_position_safe_pro(std::pair<int, int> pos, std::pair<int, int> my_tank)
-{
-	//对于发射炮弹进行判断
-	//只需要判断发射炮弹之后是否会使对方可以打到我方坦克
-	//既需要判断对方坦克现在的位置，也要考虑预测出来的移动方向
-	int abs_i = pos.first - my_tank.first;
-	int abs_j = pos.second - my_tank.second;
-	std::pair<int, int> tmp = pos;
-	tmp.first += abs_i;
-	tmp.second += abs_j;
-	while (TankGame::CoordValid(tmp.first, tmp.second))
+	void _requireDistance() const
 	{
-		if (tmp == enemy_tank[0])
-			return 0;
-		if (tmp == enemy_tank[1])
-			return 0;
-		//防止我方开了墙之后，对手正好移动过来，然后gg的局面
-		for (int k = 0; k < 4; k++)
+		if (!has_distance)
 		{
-			int tmpy = tmp.first + TankGame::dy[k], tmpx = tmp.second + TankGame::dx[k];
-			std::pair<int, int> next_position = std::make_pair(tmpy, tmpx);
-			if (next_position == enemy_tank[0])
-				return 0;
-			if (next_position == enemy_tank[1])
-				return 0;
+			bot.dis = distances.Get(field);
+			has_distance = true;
 		}
-		if (TankGame::field->gameField[tmp.first][tmp.second] != TankGame::None)
-			return 1;
-		tmp.first += abs_i;
-		tmp.second += abs_j;
 	}
-	return 1;
-}
 
-TankGame::Action Final_Action(int side, int tank, std::pair<int, int> tank_position)
-{ //当坦克到达底线，战斗即将结束
-	//需要判断是否会被对手打到
-	if (!is_position_safe(tank_position))
+	void _requireAttack() const
 	{
-		//如果会被打到，试着左右走位
-		for (int k = 0; k < 4; k++)
-			if (k % 2 == 1)
-			{
-				int tmpy = tank_position.first + TankGame::dy[k], tmpx = tank_position.second + TankGame::dx[k];
-				if (!TankGame::CoordValid(tmpx, tmpy))
-					continue;
-				if (TankGame::field->gameField[tmpy][tmpx] == TankGame::Steel)
-					continue;
-				if (!is_position_safe(std::make_pair(tmpy, tmpx)))
-					continue;
-				if (TankGame::field->gameField[tmpy][tmpx] == TankGame::None)
-				{
-					return choose_move_direction(k);
-				}
-			}
-		//否则确保自身安全，朝对手坦克开炮
-		if (tank_position.second < 4)
+		_requireDistance();
+		if (!has_attack)
 		{
-			for (int i = tank_position.second + 1; i <= 4; i++)
-				if (TankGame::field->gameField[tank_position.first][i] == TankGame::Base)
-					return TankGame::field->ActionIsValid(side, tank, TankGame::RightShoot) ? TankGame::RightShoot : TankGame::Stay;
-				else if (TankGame::field->gameField[tank_position.first][i] != TankGame::None)
-					break;
+			bot.update_attack_distance();
+			has_attack = true;
 		}
-		else
+	}
+
+	void _requireThreat() const
+	{
+		_requireAttack();
+		if (!has_threat)
 		{
-			for (int i = tank_position.second - 1; i >= 4; i--)
-				if (TankGame::field->gameField[tank_position.first][i] == TankGame::Base)
-					return TankGame::field->ActionIsValid(side, tank, TankGame::LeftShoot) ? TankGame::LeftShoot : TankGame::Stay;
-				else if (TankGame::field->gameField[tank_position.first][i] != TankGame::None)
-					break;
-		}
-		if (TankGame::field->ActionIsValid(side, tank, TankGame::LeftShoot))
-		{ //检测是否可以进行攻击
-			TankGame::Action rec = attack(side, tank);
-			if (rec != TankGame::Invalid)
-				return rec;
+			bot.update_threat();
+			has_threat = true;
 		}
 	}
-	if (tank_position.second < 4)
+};
+
+//决策策略，每个策略对象只用于一局中的一方
+class Policy
+{
+  public:
+	virtual ~Policy() {}
+
+	virtual const char *Name() const = 0;
+
+	//为analysis.Side()一方的两个坦克决定动作
+	virtual void Decide(const Analysis &analysis, TankGame::Action actions[2]) = 0;
+};
+
+//原有的启发式策略（MyAction）
+class HeuristicPolicy : public Policy
+{
+  public:
+	const char *Name() const override
 	{
-		return TankGame::field->ActionIsValid(side, tank, TankGame::RightShoot) ? TankGame::RightShoot : TankGame::Stay;
+		return "heuristic";
 	}
-	else
+
+	void Decide(const Analysis &analysis, TankGame::Action actions[2]) override
 	{
-		return TankGame::field->ActionIsValid(side, tank, TankGame::LeftShoot) ? TankGame::LeftShoot : TankGame::Stay;
+		analysis.RequireAll();
+		for (int tank = 0; tank < 2; tank++)
+			actions[tank] = analysis.Bot().MyAction(analysis.Side(), tank);
 	}
-}
+};
 
-TankGame::Action continue_life(std::pair<int, int> my_position, std::pair<int, int> target)
+//在合法动作中均匀随机选择
+class RandomPolicy : public Policy
 {
-	//续一秒！
-	int max_dis = dis[my_position.first][my_position.second][target.first][target.second], move_id = -1;
-	for (int k = 0; k < 4; k++)
+  public:
+	const char *Name() const override
 	{
-		int tmpy = my_position.first + TankGame::dy[k], tmpx = my_position.second + TankGame::dx[k];
-		if (!TankGame::CoordValid(tmpx, tmpy))
-			continue;
-		if (TankGame::field->gameField[tmpy][tmpx] == TankGame::Steel)
-			continue;
-		if (!is_position_safe(std::make_pair(tmpy, tmpx)))
-			continue;
-		if (TankGame::field->gameField[tmpy][tmpx] == TankGame::None)
-		{
-			if (dis[tmpy][tmpx][target.first][target.second] <= max_dis)
-			{
-				max_dis = dis[tmpy][tmpx][target.first][target.second];
-				move_id = k;
-			}
-		}
+		return "random";
 	}
-	if (move_id != -1)
-		return choose_move_direction(move_id);
-	else
-		return TankGame::Invalid;
-}
 
-TankGame::Action MyAction(int side, int tank)
+	void Decide(const Analysis &analysis, TankGame::Action actions[2]) override
+	{
+		for (int tank = 0; tank < 2; tank++)
+			actions[tank] = analysis.Field().SampleLegal(analysis.Side(), tank);
+	}
+};
+
+//一步极大极小搜索：枚举双方所有合法的联合动作，选出在对方最好的应对下局面评估最高的一组
+//评估只用本回合的分析结果（双方打击对方基地还需要的回合数），不在每个子局面上重新计算距离表
+class SearchPolicy : public Policy
 {
-	//判断坦克是否存活
-	if (my_tank[tank].first == -1)
-		return TankGame::Stay;
-	std::pair<int, int> tank_position = my_tank[tank];
-	std::pair<int, int> target = choose_moving_target(tank_position, TankGame::field->mySide);
-	if (target == tank_position)
-	{ //说明坦克已经到达最后目标，只需要朝着对方基地射击即可
-		return Final_Action(side, tank, tank_position);
+  public:
+	const char *Name() const override
+	{
+		return "search";
 	}
-	else
+
+	void Decide(const Analysis &analysis, TankGame::Action actions[2]) override
 	{
-		//先找是否可以直接进行移动，而不需要发射炮弹（即有多条道路）
-		for (int k = 0; k < 4; k++)
+		TankGame::TankField field = analysis.Field();
+		int side = analysis.Side();
+		std::vector<std::pair<TankGame::Action, TankGame::Action>> mine, theirs;
+		legal_joint_actions(field, side, mine);
+		legal_joint_actions(field, side ^ 1, theirs);
+		int best = INT_MIN;
+		for (auto &my_action : mine)
 		{
-			int tmpy = tank_position.first + TankGame::dy[k], tmpx = tank_position.second + TankGame::dx[k];
-			if (!TankGame::CoordValid(tmpx, tmpy))
-				continue;
-			if (TankGame::field->gameField[tmpy][tmpx] == TankGame::Steel)
-				continue;
-			if (!is_position_safe(std::make_pair(tmpy, tmpx)))
-				continue;
-			if (TankGame::field->gameField[tmpy][tmpx] == TankGame::None)
+			int worst = INT_MAX;
+			for (auto &their_action : theirs)
+			{
+				field.nextAction[side][0] = my_action.first;
+				field.nextAction[side][1] = my_action.second;
+				field.nextAction[side ^ 1][0] = their_action.first;
+				field.nextAction[side ^ 1][1] = their_action.second;
+				field.DoAction();
+				worst = std::min(worst, evaluate(analysis, field, side));
+				field.Revert();
+				if (worst <= best)
+					break;
+			}
+			if (worst > best)
 			{
-				if (judge_right_path(target, tank_position, std::make_pair(tmpy, tmpx)))
-					return choose_move_direction(k);
+				best = worst;
+				actions[0] = my_action.first;
+				actions[1] = my_action.second;
 			}
 		}
-		//如果当前格子是危险的,朝四周躲避
-		if (!is_position_safe(tank_position))
+	}
+
+  private:
+	static void legal_joint_actions(const TankGame::TankField &field, int side,
+									std::vector<std::pair<TankGame::Action, TankGame::Action>> &out)
+	{
+		std::vector<TankGame::Action> legal[2];
+		for (int tank = 0; tank < 2; tank++)
 		{
-			TankGame::Action rec = continue_life(tank_position, target);
-			if (rec != TankGame::Invalid)
-				return rec;
-		}
-		if (TankGame::field->ActionIsValid(side, tank, TankGame::LeftShoot))
-		{ //检测是否可以进行攻击
-			TankGame::Action rec = attack(side, tank);
-			if (rec != TankGame::Invalid)
-				return rec;
+			if (!field.tankAlive[side][tank])
+				legal[tank].push_back(TankGame::Stay);
+			else
+				for (int act = TankGame::Stay; act <= TankGame::LeftShoot; act++)
+					if (field.ActionIsValid(side, tank, (TankGame::Action)act))
+						legal[tank].push_back((TankGame::Action)act);
 		}
-		//否则发射炮弹开路
-		for (int k = 0; k < 4; k++)
-		{
-			int tmpy = tank_position.first + TankGame::dy[k], tmpx = tank_position.second + TankGame::dx[k];
-			if (!TankGame::CoordValid(tmpx, tmpy))
-				continue;
-			if (TankGame::field->gameField[tmpy][tmpx] == TankGame::Steel)
-				continue;
-			if (!is_position_safe_pro(std::make_pair(tmpy, tmpx), tank_position))
-				continue;
-			if (TankGame::field->gameField[tmpy][tmpx] == TankGame::Brick)
+		for (auto first : legal[0])
+			for (auto second : legal[1])
+				out.push_back(std::make_pair(first, second));
+	}
+
+	//以side方的视角评估局面，分数越高越好
+	static int evaluate(const Analysis &analysis, const TankGame::TankField &field, int side)
+	{
+		const int win = 1000000, dead_tank_cost = 40;
+		TankGame::GameResult result = field.GetGameResult();
+		if (result == side)
+			return win;
+		if (result == (side ^ 1))
+			return -win;
+		if (result == TankGame::Draw)
+			return 0;
+		int score = 0;
+		for (int s = 0; s < 2; s++)
+			for (int tank = 0; tank < 2; tank++)
 			{
-				if (judge_right_path(target, tank_position, std::make_pair(tmpy, tmpx)))
-					return choose_shoot_direction(side, tank, k);
+				int cost = field.tankAlive[s][tank]
+							   ? analysis.AttackCost(std::make_pair(field.tankY[s][tank], field.tankX[s][tank]), s)
+							   : dead_tank_cost;
+				score += s == side ? -cost : cost;
 			}
-		}
+		return score;
+	}
+};
+
+//按名称创建策略，未知的名称返回nullptr
+Policy *create_policy(const string &name)
+{
+	if (name == "heuristic")
+		return new HeuristicPolicy;
+	if (name == "random")
+		return new RandomPolicy;
+	if (name == "search")
+		return new SearchPolicy;
+	return nullptr;
+}
+
+//从globaldata中读取要使用的策略，格式为{"policy":"名称"}，没有指定或无法识别时使用heuristic
+Policy *create_policy_from_globaldata(const string &globaldata)
+{
+	Json::Value config;
+	Policy *policy = nullptr;
+	if (!globaldata.empty() && Json::Reader().parse(globaldata, config) && config.isObject())
+		policy = create_policy(config["policy"].asString());
+	return policy ? policy : new HeuristicPolicy;
+}
+
+//用policy为game.field中side一方的两个坦克做决策，并记下敌方坦克的位置用于下回合的预测
+//同一局的双方可以用各自的BotContext和同一个game做决策，距离表只会计算一次
+void decide_turn(TankGame::GameContext &game, BotContext &bot, Policy &policy, int side, TankGame::Action &tank0,
+				 TankGame::Action &tank1)
+{
+	Analysis analysis(bot, game.distances, *game.field, side);
+	TankGame::Action actions[2];
+	{
+		TankGame::Profiler::ScopedTimer timer(TankGame::Profiler::DecidePhase);
+		policy.Decide(analysis, actions);
 	}
-	return TankGame::Stay;
+	tank0 = actions[0];
+	tank1 = actions[1];
+	bot.last_enemy_tank[0] = analysis.EnemyTank(0);
+	bot.last_enemy_tank[1] = analysis.EnemyTank(1);
 }
 
+// 本地工具（tools/ 下）直接包含本文件，定义 TANKGAME_NO_MAIN 以使用自己的 main
+#ifndef TANKGAME_NO_MAIN
+//长时运行开关：开启时（需要在 Botzone 上选择“允许长时运行”）程序在回合之间一直运行，局面保存在内存中，不输出存档
+//关闭时每回合提交后退出，下回合重新运行时从 data 中的存档恢复局面
+const bool keep_running = true;
+
+//本地日志开关（只在本地编译时有效）：开启时每回合提交前把本局到目前为止的对局记录写到 liveRecordPath，
+//并把各阶段的耗时追加到 Profiler::profileLogPath；写文件不计入任何阶段的耗时
+const bool local_logs = false;
+
 int main()
 {
-	srand((unsigned)time(nullptr));
+	TankGame::threadRandom.Seed(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+	TankGame::GameContext game;
+	std::unique_ptr<BotContext> bot(new BotContext);
+	std::unique_ptr<Policy> policy;
+	string bot_state;
 	while (true)
 	{
 		string data, globaldata;
-		TankGame::ReadInput(cin, data, globaldata);
+		TankGame::ReadInput(game, cin, data, globaldata);
+		if (!data.empty())
+			bot->load_bot_state(data);
+		if (!policy)
+			policy.reset(create_policy_from_globaldata(globaldata));
 		//Debug开关
-		//TankGame::field->DebugPrint();
-		update_info();
-		TankGame::SubmitAndDontExit(MyAction(TankGame::field->mySide, 0), MyAction(TankGame::field->mySide, 1));
-		last_enemy_tank[0] = enemy_tank[0];
-		last_enemy_tank[1] = enemy_tank[1];
+		//game.field->DebugPrint();
+		TankGame::Action tank0, tank1;
+		decide_turn(game, *bot, *policy, game.field->mySide, tank0, tank1);
+#ifndef _BOTZONE_ONLINE
+		//关闭长时运行时程序在提交后直接退出，因此在提交之前写
+		if (local_logs)
+		{
+			TankGame::RecordWriter(TankGame::liveRecordPath, false)
+				.Write(game.fieldMasks, *game.field, game.field->GetGameResult());
+			TankGame::Profiler::AppendLog(game.field->currentTurn);
+		}
+#endif
+		{
+			TankGame::Profiler::ScopedTimer timer(TankGame::Profiler::OutputPhase);
+			//debug 中是本回合各阶段的耗时
+			if (keep_running)
+				TankGame::SubmitAndDontExit(game, tank0, tank1, TankGame::Profiler::Summary());
+			else
+			{
+				//附带存档，下回合重新运行时不需要回放整局
+				bot->save_bot_state(bot_state);
+				TankGame::SubmitAndExit(tank0, tank1, TankGame::Profiler::Summary(), TankGame::MakeCheckpoint(game, bot_state));
+			}
+		}
+		TankGame::Profiler::EndTurn();
 	}
-}
\ No newline at end of file
+}
+#endif
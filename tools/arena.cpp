@@ -0,0 +1,229 @@
+// 本地对战平台：在 MapGenerator 生成的随机场地上让两个策略大量对局，统计胜率、对局速度和每回合决策耗时
+// 编译：g++ -O2 -std=c++11 -pthread -o arena tools/arena.cpp
+// 用法：arena [-n 对局数] [-t 线程数] [-s 随机种子] [-o 对局记录文件] [策略A] [策略B]
+// 可用的策略见 create_policy：heuristic（即 MyAction）、search、random
+// A 和 B 轮流执蓝方和红方，胜负均从 A 的角度统计
+
+#define TANKGAME_NO_MAIN
+#include "../main.cpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace Arena
+{
+using TankGame::Action;
+using TankGame::TankField;
+using TankGame::sideCount;
+using TankGame::tankPerSide;
+
+// 从 A 的角度看的对局结果
+enum Outcome
+{
+	Win,
+	Loss,
+	DrawGame
+};
+
+struct WorkerResult
+{
+	long long outcomes[3] = {};
+	long long turns = 0;
+	std::vector<double> latency[2]; // 每个策略每回合的决策耗时（微秒）
+	std::string records;            // 用 AppendRecord 编码的对局记录
+};
+
+Outcome PlayGame(const char *players[2], int aSide, unsigned int seed, bool record, WorkerResult &result)
+{
+	int hasBrick[3];
+	TankGame::MapGenerator(seed).Next(hasBrick);
+	// 随机策略的选择也只由种子决定，结果与线程数和调度无关
+	TankGame::threadRandom.Seed(seed);
+	// 双方共用 game 中的距离表
+	TankGame::GameContext game;
+	game.field.reset(new TankField(hasBrick, 0));
+	TankField &field = *game.field;
+	std::unique_ptr<Policy> policies[sideCount] = {
+		std::unique_ptr<Policy>(create_policy(players[aSide])), std::unique_ptr<Policy>(create_policy(players[1 - aSide]))};
+	// 每一方有自己的 BotContext，不同线程中的对局互不影响
+	std::unique_ptr<BotContext> bots[sideCount] = {std::unique_ptr<BotContext>(new BotContext),
+												   std::unique_ptr<BotContext>(new BotContext)};
+
+	TankGame::GameResult winner;
+	while ((winner = field.GetGameResult()) == TankGame::NotFinished)
+	{
+		Action acts[sideCount][tankPerSide];
+		for (int side = 0; side < sideCount; side++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			decide_turn(game, *bots[side], *policies[side], side, acts[side][0], acts[side][1]);
+			auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+			result.latency[side == aSide ? 0 : 1].push_back(elapsed.count());
+		}
+		result.turns++;
+
+		// 非法动作判负，双方都非法则平局
+		bool valid[sideCount];
+		for (int side = 0; side < sideCount; side++)
+		{
+			valid[side] = true;
+			for (int tank = 0; tank < tankPerSide; tank++)
+				if (field.tankAlive[side][tank] && !field.ActionIsValid(side, tank, acts[side][tank]))
+					valid[side] = false;
+		}
+		if (!valid[0] || !valid[1])
+		{
+			winner = valid[0] == valid[1] ? TankGame::Draw : (valid[0] ? TankGame::Blue : TankGame::Red);
+			break;
+		}
+
+		for (int side = 0; side < sideCount; side++)
+			for (int tank = 0; tank < tankPerSide; tank++)
+				field.nextAction[side][tank] = acts[side][tank];
+		field.DoAction();
+	}
+	if (record)
+		TankGame::AppendRecord(result.records, hasBrick, field, winner);
+	if (winner == TankGame::Draw)
+		return DrawGame;
+	return winner == aSide ? Win : Loss;
+}
+
+// 简单的 work-stealing 线程池：每个线程先处理自己队列尾部的对局，空了再从别的队列头部偷
+class WorkStealingPool
+{
+  public:
+	WorkStealingPool(int threads, int jobs) : queues(threads), locks(threads)
+	{
+		for (int job = 0; job < jobs; job++)
+			queues[job % threads].push_back(job);
+	}
+
+	bool Next(int worker, int &job)
+	{
+		if (_pop(worker, job, false))
+			return true;
+		for (int i = 1; i < (int)queues.size(); i++)
+			if (_pop((worker + i) % queues.size(), job, true))
+				return true;
+		return false;
+	}
+
+  private:
+	std::vector<std::deque<int>> queues;
+	std::vector<std::mutex> locks;
+
+	bool _pop(int queue, int &job, bool steal)
+	{
+		std::lock_guard<std::mutex> guard(locks[queue]);
+		if (queues[queue].empty())
+			return false;
+		if (steal)
+		{
+			job = queues[queue].front();
+			queues[queue].pop_front();
+		}
+		else
+		{
+			job = queues[queue].back();
+			queues[queue].pop_back();
+		}
+		return true;
+	}
+};
+
+double Percentile(std::vector<double> &values, double p)
+{
+	if (values.empty())
+		return 0;
+	size_t index = std::min(values.size() - 1, (size_t)(p * values.size()));
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+	return values[index];
+}
+} // namespace Arena
+
+int main(int argc, char **argv)
+{
+	int games = 1000, threads = std::max(1U, std::thread::hardware_concurrency());
+	unsigned int seed = 1;
+	const char *names[2] = {"heuristic", "random"}, *recordPath = nullptr;
+	int nameCount = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-n") && i + 1 < argc)
+			games = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+			threads = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+			seed = (unsigned int)strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+			recordPath = argv[++i];
+		else if (nameCount < 2)
+			names[nameCount++] = argv[i];
+	}
+	if (games <= 0)
+	{
+		std::cerr << "对局数必须为正数：" << games << endl;
+		return 1;
+	}
+	for (int i = 0; i < 2; i++)
+		if (!std::unique_ptr<Policy>(create_policy(names[i])))
+		{
+			std::cerr << "未知的策略：" << names[i] << endl;
+			return 1;
+		}
+
+	Arena::WorkStealingPool pool(threads, games);
+	std::vector<Arena::WorkerResult> results(threads);
+	std::vector<std::thread> workers;
+	auto start = std::chrono::steady_clock::now();
+	for (int worker = 0; worker < threads; worker++)
+		workers.emplace_back([&, worker]() {
+			int job;
+			while (pool.Next(worker, job))
+			{
+				Arena::Outcome outcome = Arena::PlayGame(names, job % 2, seed * 1000003U + job, recordPath != nullptr, results[worker]);
+				results[worker].outcomes[outcome]++;
+			}
+		});
+	for (auto &worker : workers)
+		worker.join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	Arena::WorkerResult total;
+	for (auto &result : results)
+	{
+		for (int i = 0; i < 3; i++)
+			total.outcomes[i] += result.outcomes[i];
+		total.turns += result.turns;
+		for (int i = 0; i < 2; i++)
+			total.latency[i].insert(total.latency[i].end(), result.latency[i].begin(), result.latency[i].end());
+	}
+
+	if (recordPath)
+	{
+		// 记录按线程分组，顺序与对局编号无关
+		TankGame::RecordWriter writer(recordPath, false);
+		for (auto &result : results)
+			writer.WriteEncoded(result.records);
+		if (!writer.Flush())
+			std::cerr << "无法写入对局记录：" << recordPath << endl;
+	}
+
+	cout << names[0] << " vs " << names[1] << "：" << games << " 局，" << threads << " 线程" << endl;
+	cout << "胜 " << total.outcomes[Arena::Win] * 100.0 / games << "%  平 "
+		 << total.outcomes[Arena::DrawGame] * 100.0 / games << "%  负 "
+		 << total.outcomes[Arena::Loss] * 100.0 / games << "%" << endl;
+	cout << "每秒 " << games / seconds << " 局，平均每局 " << (double)total.turns / games << " 回合" << endl;
+	for (int i = 0; i < 2; i++)
+		cout << names[i] << " 每回合决策耗时（微秒）：p50 " << Arena::Percentile(total.latency[i], 0.5)
+			 << "  p90 " << Arena::Percentile(total.latency[i], 0.9)
+			 << "  p99 " << Arena::Percentile(total.latency[i], 0.99)
+			 << "  max " << Arena::Percentile(total.latency[i], 1) << endl;
+	return 0;
+}
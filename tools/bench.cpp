@@ -0,0 +1,202 @@
+// 启发式 bot 热点函数的微基准测试，结果以 JSON 输出到 stdout，便于跟踪性能变化
+// 编译：g++ -O2 -std=c++11 -o bench tools/bench.cpp
+// 用法：bench [-g 对局数] [-s 随机种子] [-r 轮数]
+// 局面库由 heuristic 自我对弈得到：用 MapGenerator 按种子生成场地，记录每一回合双方做决策时的局面，
+// 因此相同的参数总是得到相同的局面库
+// 每个样本是在一个局面上连续调用若干次的平均耗时；cycles 为 TSC 计数（在 x86 上即参考周期数）
+
+#define TANKGAME_NO_MAIN
+#include "../main.cpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+
+namespace Bench
+{
+using TankGame::Action;
+using TankGame::TankField;
+using TankGame::sideCount;
+using TankGame::tankPerSide;
+
+// 一个做决策时的局面（field.mySide 为做决策的一方）
+struct Position
+{
+	TankField field;
+	std::pair<int, int> lastEnemyTank[tankPerSide];
+};
+
+// 防止被测函数的结果被优化掉
+volatile long long sink;
+
+// 所有热点函数都在这个 BotContext 上运行，距离表取自 distances
+BotContext *bot;
+TankGame::DistanceCache *distances;
+
+// 按 position 设置 bot 的状态，之后所有热点函数都在这个局面上运行
+void Prepare(Position &position)
+{
+	bot->field = &position.field;
+	std::copy(position.lastEnemyTank, position.lastEnemyTank + tankPerSide, bot->last_enemy_tank);
+	distances->Invalidate();
+	bot->update_info(*distances, position.field.mySide);
+}
+
+void GenerateCorpus(int games, unsigned long long seed, std::vector<Position> &corpus)
+{
+	for (int game = 0; game < games; game++)
+	{
+		int hasBrick[3];
+		TankGame::MapGenerator(seed + game).Next(hasBrick);
+		TankField field(hasBrick, TankGame::Blue);
+		std::pair<int, int> lastEnemyTank[sideCount][tankPerSide] = {};
+		while (field.GetGameResult() == TankGame::NotFinished && field.currentTurn < 100)
+		{
+			for (int side = 0; side < sideCount; side++)
+			{
+				field.mySide = side;
+				corpus.push_back(Position{field, {lastEnemyTank[side][0], lastEnemyTank[side][1]}});
+				Prepare(corpus.back());
+				for (int tank = 0; tank < tankPerSide; tank++)
+					field.nextAction[side][tank] = bot->MyAction(side, tank);
+				std::copy(bot->enemy_tank, bot->enemy_tank + tankPerSide, lastEnemyTank[side]);
+			}
+			if (!field.DoAction())
+				break;
+		}
+	}
+}
+
+struct Benchmark
+{
+	const char *name;
+
+	// 每个样本连续调用的次数，较快的函数需要多次调用才能超过计时的精度
+	int repeat;
+
+	void (*run)();
+};
+
+void RunUpdateDistance()
+{
+	distances->Invalidate();
+	sink += distances->Get(*bot->field)[0][0][8][8];
+}
+
+void RunUpdateAttackDistance()
+{
+	bot->update_attack_distance();
+	sink += bot->attack_distance[4][0];
+}
+
+void RunUpdateInfo()
+{
+	distances->Invalidate();
+	bot->update_info(*distances, bot->my_side);
+	sink += bot->safty_block[4][4];
+}
+
+void RunChooseMovingTarget()
+{
+	for (int tank = 0; tank < tankPerSide; tank++)
+		if (bot->alive[bot->my_side][tank])
+			sink += bot->choose_moving_target(bot->my_tank[tank], bot->my_side).second;
+}
+
+void RunAttack()
+{
+	for (int tank = 0; tank < tankPerSide; tank++)
+		if (bot->alive[bot->my_side][tank])
+			sink += bot->attack(bot->my_side, tank);
+}
+
+void RunIsPositionSafePro()
+{
+	for (int tank = 0; tank < tankPerSide; tank++)
+		if (bot->alive[bot->my_side][tank])
+			for (int k = 0; k < 4; k++)
+			{
+				std::pair<int, int> position = bot->my_tank[tank];
+				sink += bot->is_position_safe_pro(
+					std::make_pair(position.first + TankGame::dy[k], position.second + TankGame::dx[k]), position);
+			}
+}
+
+void RunMyAction()
+{
+	for (int tank = 0; tank < tankPerSide; tank++)
+		sink += bot->MyAction(bot->my_side, tank);
+}
+
+const Benchmark benchmarks[] = {
+	{"update_distance", 1, RunUpdateDistance},
+	{"update_attack_distance", 1000, RunUpdateAttackDistance},
+	{"update_info", 1, RunUpdateInfo},
+	{"choose_moving_target", 1000, RunChooseMovingTarget},
+	{"attack", 1000, RunAttack},
+	{"is_position_safe_pro", 1000, RunIsPositionSafePro},
+	{"MyAction", 100, RunMyAction}};
+
+double Percentile(std::vector<double> &values, double p)
+{
+	size_t index = std::min(values.size() - 1, (size_t)(p * values.size()));
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+	return values[index];
+}
+} // namespace Bench
+
+int main(int argc, char **argv)
+{
+	int games = 10, rounds = 3;
+	unsigned long long seed = 1;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "-g"))
+			games = std::max(1, atoi(argv[i + 1]));
+		else if (!strcmp(argv[i], "-s"))
+			seed = strtoull(argv[i + 1], nullptr, 10);
+		else if (!strcmp(argv[i], "-r"))
+			rounds = std::max(1, atoi(argv[i + 1]));
+	}
+
+	std::unique_ptr<BotContext> bot(new BotContext);
+	std::unique_ptr<TankGame::DistanceCache> distances(new TankGame::DistanceCache);
+	Bench::bot = bot.get();
+	Bench::distances = distances.get();
+	std::vector<Bench::Position> corpus;
+	Bench::GenerateCorpus(games, seed, corpus);
+
+	// 用整个测试过程校准 TSC 和实际时间的比例
+	auto startTime = std::chrono::steady_clock::now();
+	unsigned long long startTicks = TankGame::Profiler::Now();
+	std::vector<std::vector<double>> samples(sizeof(Bench::benchmarks) / sizeof(Bench::benchmarks[0]));
+	for (int round = 0; round < rounds; round++)
+		for (auto &position : corpus)
+		{
+			Bench::Prepare(position);
+			for (size_t b = 0; b < samples.size(); b++)
+			{
+				const Bench::Benchmark &benchmark = Bench::benchmarks[b];
+				unsigned long long start = TankGame::Profiler::Now();
+				for (int i = 0; i < benchmark.repeat; i++)
+					benchmark.run();
+				samples[b].push_back((double)(TankGame::Profiler::Now() - start) / benchmark.repeat);
+			}
+		}
+	double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+	double ticksPerNs = (TankGame::Profiler::Now() - startTicks) / elapsedNs;
+
+	printf("{\n  \"corpus\": {\"games\": %d, \"seed\": %llu, \"positions\": %d, \"rounds\": %d},\n",
+		   games, seed, (int)corpus.size(), rounds);
+	printf("  \"ticks_per_ns\": %.4f,\n  \"benchmarks\": [\n", ticksPerNs);
+	for (size_t b = 0; b < samples.size(); b++)
+	{
+		double median = Bench::Percentile(samples[b], 0.5), p99 = Bench::Percentile(samples[b], 0.99);
+		printf("    {\"name\": \"%s\", \"samples\": %d, \"median_ns\": %.1f, \"p99_ns\": %.1f, "
+			   "\"median_cycles\": %.0f, \"p99_cycles\": %.0f}%s\n",
+			   Bench::benchmarks[b].name, (int)samples[b].size(), median / ticksPerNs, p99 / ticksPerNs,
+			   median, p99, b + 1 < samples.size() ? "," : "");
+	}
+	printf("  ]\n}\n");
+	return 0;
+}
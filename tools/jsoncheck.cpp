@@ -0,0 +1,133 @@
+// jsoncpp 回归检查：用容易出错的输入检查 Json::Reader、Json::Writer 和 Json::LazyValue，有错误时返回 1
+// 编译：g++ -O2 -std=c++11 -o jsoncheck tools/jsoncheck.cpp
+// 用法：jsoncheck
+// 数值：Reader 解析出的 double 必须与 strtod 的结果完全相同（包括 0 的符号），
+// FastWriter 写出的文本再解析回来也必须相等（-0 写成整数 -0，读回来是 0）
+// LazyValue：size、getMemberNames 和各成员的 asString 必须与 decode() 得到的 Value 一致
+// OutputBuffer：写到无效的文件描述符时 flush 必须失败
+
+#include "../jsoncpp/json.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace JsonCheck
+{
+// 有效数字超过 19 位、或前若干位恰好是 2^64 的倍数的数，曾在快速路径中溢出成 0
+const char *numbers[] = {
+	"0", "-0.0", "1", "-1", "0.5", "1e22", "1e23", "1.5e25", "9007199254740993", "1000000000000000000000",
+	"18446744073709551615", "18446744073709551616", "-18446744073709551616", "18446744073709551616.0",
+	"36893488147419103232", "1.8446744073709551616e3", "184467440737095516150", "12345678901234567890123",
+	"0.00000000000000000000000001234", "0.1", "2.2250738585072014e-308", "1.7976931348623157e308",
+	"4.9406564584124654e-324", "123456789012345678901234567890e-10"};
+
+int errors = 0;
+
+void Fail(const char *input, const char *what, double expected, double actual)
+{
+	printf("%s：%s，应为 %.17g，实际为 %.17g\n", input, what, expected, actual);
+	errors++;
+}
+
+// 完全相同，包括 0 的符号
+bool Same(double a, double b)
+{
+	return a == b && std::signbit(a) == std::signbit(b);
+}
+
+void CheckNumber(const char *input)
+{
+	double expected = strtod(input, nullptr);
+	// 放在数组中解析，结果与 strictRoot 的设置无关
+	std::string text = std::string("[") + input + "]";
+	Json::Reader reader;
+	Json::Value root;
+	if (!reader.parse(text, root) || !root.isArray() || root.size() != 1)
+	{
+		printf("%s：解析失败\n", input);
+		errors++;
+		return;
+	}
+	double actual = root[0].asDouble();
+	if (!Same(expected, actual))
+		return Fail(input, "解析结果不同", expected, actual);
+
+	Json::FastWriter writer;
+	std::string written = writer.write(Json::Value(expected));
+	written.erase(written.find_last_not_of('\n') + 1);
+	Json::Value reparsed;
+	if (!reader.parse(written, reparsed) || reparsed.asDouble() != expected)
+		Fail(input, ("写出为 " + written + " 后无法还原").c_str(), expected, reparsed.asDouble());
+}
+
+// 重复的成员名（decode() 只保留最后一个）和格式错误的字符串（读作 null，asString 为空串）
+const char *lazyDocuments[] = {
+	"{\"a\":1,\"a\":2}", "{\"a\":1,\"b\":[1],\"a\":null,\"c\":3,\"b\":\"x\"}", "{\"a\\u0062\":1,\"ab\":2}",
+	"{\"s\":\"\\taaaa\\ud83d\\ude00key\\ud800\",\"q\":\"\\q\u00e9\",\"u\":\"\\u12k0\"}",
+	"{\"bad\\q\":1,\"\":2,\"x\":\"\\u00e9\"}", "{}", "[1,\"\\q\",{\"a\":1,\"a\":{}}]"};
+
+// 容器比较大小，其他值比较 asString
+bool SameMember(const Json::LazyValue &lazy, const Json::Value &decoded)
+{
+	if (decoded.isArray() || decoded.isObject())
+		return lazy.size() == decoded.size();
+	return lazy.asString() == decoded.asString();
+}
+
+void CheckLazy(const char *text)
+{
+	Json::Reader reader;
+	Json::LazyDocument document;
+	if (!reader.parse(text, text + strlen(text), document))
+	{
+		printf("%s：解析失败\n", text);
+		errors++;
+		return;
+	}
+	Json::LazyValue lazy = document.root();
+	Json::Value decoded = lazy.decode();
+	bool same = lazy.size() == decoded.size();
+	if (lazy.isObject())
+	{
+		Json::Value::Members names = lazy.getMemberNames();
+		same = same && names.size() == decoded.size();
+		for (auto &name : names)
+			same = same && decoded.isMember(name) && SameMember(lazy[name], decoded[name]);
+	}
+	else
+		for (Json::ArrayIndex index = 0; index < lazy.size(); index++)
+			same = same && SameMember(lazy[index], decoded[index]);
+	if (!same)
+	{
+		printf("%s：LazyValue 与 decode() 不一致\n", text);
+		errors++;
+	}
+}
+
+void CheckOutputBuffer()
+{
+	Json::OutputBuffer out(-1, 16);
+	Json::FastWriter writer;
+	writer.write(out, Json::Value("写到无效文件描述符的输出"));
+	if (out.flush())
+	{
+		printf("OutputBuffer(-1)：flush 没有失败\n");
+		errors++;
+	}
+}
+} // namespace JsonCheck
+
+int main()
+{
+	for (const char *input : JsonCheck::numbers)
+		JsonCheck::CheckNumber(input);
+	for (const char *text : JsonCheck::lazyDocuments)
+		JsonCheck::CheckLazy(text);
+	JsonCheck::CheckOutputBuffer();
+	printf("%d 个数值，%d 个文档，%d 个错误\n", (int)(sizeof(JsonCheck::numbers) / sizeof(JsonCheck::numbers[0])),
+		   (int)(sizeof(JsonCheck::lazyDocuments) / sizeof(JsonCheck::lazyDocuments[0])), JsonCheck::errors);
+	return JsonCheck::errors ? 1 : 0;
+}
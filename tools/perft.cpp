@@ -0,0 +1,247 @@
+// perft：从给定场地出发，用 DoAction / Revert 枚举双方所有合法的联合动作直到深度 d
+// 输出每层的节点数和平均分支数、结束局面的统计与校验和，以及每秒节点数，用于衡量和对照局面引擎
+// 编译：g++ -O2 -std=c++11 -o perft tools/perft.cpp（加 -mavx2 则检查 BatchField 的 AVX2 实现）
+// 用法：perft [-d 深度] [-s 地图种子] [-m 砖块0 砖块1 砖块2]
+//       perft -batch 局数 [-n 步数] [-s 种子]
+// 不指定 -m 时使用 MapGenerator 按种子生成的场地
+// -batch：让 BatchField 和 TankField 同步进行若干局随机对局，每一步比较两者的结果，有差异时返回 1，
+// 同时分别统计 StepAll 和 DoAction 每局每步的耗时
+
+#define TANKGAME_NO_MAIN
+#include "../main.cpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace Perft
+{
+using TankGame::Action;
+using TankGame::TankField;
+using TankGame::sideCount;
+using TankGame::tankPerSide;
+
+const int maxDepth = 8;
+
+struct Counters
+{
+	// nodes[d] 为第 d 层的节点数（第 0 层为根），expanded[d] 为第 d 层中被展开的节点数
+	long long nodes[maxDepth + 1] = {}, expanded[maxDepth + 1] = {};
+
+	// 各层中游戏已经结束的局面按结果（蓝胜、红胜、平局）计数
+	long long results[3] = {};
+
+	// 所有结束局面的哈希之和，与枚举顺序无关
+	unsigned long long checksum = 0;
+};
+
+unsigned long long HashField(const TankField &field)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	const unsigned char *cells = (const unsigned char *)field.gameField;
+	for (size_t i = 0; i < sizeof(field.gameField); i++)
+		hash = (hash ^ cells[i]) * 1099511628211ULL;
+	return (hash ^ (unsigned long long)field.currentTurn) * 1099511628211ULL;
+}
+
+void Search(TankField &field, int depth, int maxDepth, Counters &counters)
+{
+	counters.nodes[depth]++;
+	TankGame::GameResult result = field.GetGameResult();
+	if (result != TankGame::NotFinished)
+	{
+		counters.results[result == TankGame::Draw ? 2 : result]++;
+		counters.checksum += HashField(field) * (unsigned long long)(result + 3);
+		return;
+	}
+	if (depth == maxDepth)
+		return;
+	counters.expanded[depth]++;
+
+	// 每个坦克的合法动作，已炸的坦克只能 Stay
+	Action legal[sideCount * tankPerSide][TankGame::LeftShoot - TankGame::Stay + 1];
+	int legalCount[sideCount * tankPerSide];
+	for (int side = 0; side < sideCount; side++)
+		for (int tank = 0; tank < tankPerSide; tank++)
+		{
+			int i = side * tankPerSide + tank, &count = legalCount[i] = 0;
+			if (!field.tankAlive[side][tank])
+			{
+				legal[i][count++] = TankGame::Stay;
+				continue;
+			}
+			for (int act = TankGame::Stay; act <= TankGame::LeftShoot; act++)
+				if (field.ActionIsValid(side, tank, (Action)act))
+					legal[i][count++] = (Action)act;
+		}
+
+	int choice[sideCount * tankPerSide] = {};
+	while (true)
+	{
+		for (int i = 0; i < sideCount * tankPerSide; i++)
+			field.nextAction[i / tankPerSide][i % tankPerSide] = legal[i][choice[i]];
+		field.DoAction();
+		Search(field, depth + 1, maxDepth, counters);
+		field.Revert();
+
+		// 像计数器一样枚举下一个联合动作
+		int i = 0;
+		while (i < sideCount * tankPerSide && ++choice[i] == legalCount[i])
+			choice[i++] = 0;
+		if (i == sideCount * tankPerSide)
+			break;
+	}
+}
+// 检查 BatchField 的第 game 局与 field 是否相同，不同时输出第一处差异
+bool SameState(const TankGame::BatchField &batch, int game, const TankField &field)
+{
+	if (batch.currentTurn[game] != field.currentTurn || batch.GetGameResult(game) != field.GetGameResult())
+	{
+		cout << "回合数或结果不同" << endl;
+		return false;
+	}
+	for (int y = 0; y < TankGame::fieldHeight; y++)
+		for (int x = 0; x < TankGame::fieldWidth; x++)
+			if (batch.GetItems(game, x, y) != field.gameField[y][x])
+			{
+				cout << "格子 (" << x << ", " << y << ") 不同：" << batch.GetItems(game, x, y) << " / "
+					 << field.gameField[y][x] << endl;
+				return false;
+			}
+	// 合法动作相同说明坦克存活情况和上回合是否射击也相同
+	for (int side = 0; side < sideCount; side++)
+		for (int tank = 0; tank < tankPerSide; tank++)
+			for (int act = TankGame::Stay; act <= TankGame::LeftShoot; act++)
+				if (field.tankAlive[side][tank] &&
+					batch.ActionIsValid(game, side, tank, (Action)act) != field.ActionIsValid(side, tank, (Action)act))
+				{
+					cout << "坦克 " << side << "-" << tank << " 的动作 " << act << " 是否合法不同" << endl;
+					return false;
+				}
+	return true;
+}
+
+// 同步进行 games 局随机对局，每局 steps 步（结束的局面用新场地重开），返回是否全部一致
+// 动作大多从合法动作中随机选择，偶尔在所有动作中任选，用来检查不合法的动作是否同样被拒绝
+bool CompareBatch(int games, int steps, unsigned long long seed)
+{
+	TankGame::MapGenerator generator(seed);
+	TankGame::threadRandom.Seed(seed);
+	TankGame::BatchField batch(games);
+	std::vector<TankField> fields;
+	for (int game = 0; game < games; game++)
+	{
+		int hasBrick[3];
+		generator.Next(hasBrick);
+		fields.push_back(TankField(hasBrick, TankGame::Blue));
+		batch.Load(game, fields.back());
+	}
+
+	std::unique_ptr<Action[][sideCount][tankPerSide]> actions(new Action[games][sideCount][tankPerSide]);
+	std::unique_ptr<bool[]> applied(new bool[games]), done(new bool[games]);
+	double batchSeconds = 0, fieldSeconds = 0;
+	long long restarts = 0;
+	for (int step = 0; step < steps; step++)
+	{
+		for (int game = 0; game < games; game++)
+			for (int side = 0; side < sideCount; side++)
+				for (int tank = 0; tank < tankPerSide; tank++)
+					actions[game][side][tank] =
+						TankGame::threadRandom.Uniform(32)
+							? fields[game].SampleLegal(side, tank)
+							: (Action)(TankGame::threadRandom.Uniform(TankGame::LeftShoot - TankGame::Stay + 1) + TankGame::Stay);
+
+		auto start = std::chrono::steady_clock::now();
+		batch.StepAll(actions.get(), applied.get());
+		auto middle = std::chrono::steady_clock::now();
+		for (int game = 0; game < games; game++)
+		{
+			TankField &field = fields[game];
+			for (int side = 0; side < sideCount; side++)
+				for (int tank = 0; tank < tankPerSide; tank++)
+					field.nextAction[side][tank] = actions[game][side][tank];
+			done[game] = field.DoAction();
+		}
+		batchSeconds += std::chrono::duration<double>(middle - start).count();
+		fieldSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - middle).count();
+
+		for (int game = 0; game < games; game++)
+		{
+			if (applied[game] != done[game] || !SameState(batch, game, fields[game]))
+			{
+				cout << "第 " << step << " 步第 " << game << " 局不一致（DoAction 返回 " << done[game] << "，StepAll 为 "
+					 << applied[game] << "）" << endl;
+				return false;
+			}
+			if (fields[game].GetGameResult() != TankGame::NotFinished)
+			{
+				int hasBrick[3];
+				generator.Next(hasBrick);
+				fields[game] = TankField(hasBrick, TankGame::Blue);
+				batch.Load(game, fields[game]);
+				restarts++;
+			}
+		}
+	}
+	double total = (double)games * steps;
+	cout << games << " 局共 " << (long long)total << " 步一致，其中 " << restarts << " 局下完后重开" << endl;
+	cout << "每局每步：StepAll " << batchSeconds / total * 1e9 << " ns，DoAction " << fieldSeconds / total * 1e9
+		 << " ns，StepAll 快 " << fieldSeconds / batchSeconds << " 倍"
+#ifdef __AVX2__
+		 << "（AVX2）"
+#endif
+		 << endl;
+	return true;
+}
+} // namespace Perft
+
+int main(int argc, char **argv)
+{
+	int depth = 2, batchGames = 0, batchSteps = 1000;
+	unsigned long long seed = 1;
+	int hasBrick[3];
+	bool hasMap = false;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-batch") && i + 1 < argc)
+			batchGames = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+			batchSteps = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "-d") && i + 1 < argc)
+			depth = std::max(0, std::min(Perft::maxDepth, atoi(argv[++i])));
+		else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+			seed = strtoull(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "-m") && i + 3 < argc)
+		{
+			for (int j = 0; j < 3; j++)
+				hasBrick[j] = atoi(argv[++i]);
+			hasMap = true;
+		}
+	}
+	if (batchGames)
+		return Perft::CompareBatch(batchGames, batchSteps, seed) ? 0 : 1;
+	if (!hasMap)
+		TankGame::MapGenerator(seed).Next(hasBrick);
+
+	TankGame::TankField field(hasBrick, TankGame::Blue);
+	field.DebugPrint();
+	Perft::Counters counters;
+	auto start = std::chrono::steady_clock::now();
+	Perft::Search(field, 0, depth, counters);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	long long total = 0;
+	for (int d = 0; d <= depth; d++)
+	{
+		total += counters.nodes[d];
+		cout << "深度 " << d << "：" << counters.nodes[d] << " 个节点";
+		if (d < depth && counters.expanded[d])
+			cout << "，平均分支数 " << (double)counters.nodes[d + 1] / counters.expanded[d];
+		cout << endl;
+	}
+	cout << "结束局面：蓝胜 " << counters.results[TankGame::Blue] << "，红胜 " << counters.results[TankGame::Red]
+		 << "，平局 " << counters.results[2] << "，校验和 " << std::hex << counters.checksum << std::dec << endl;
+	cout << "共 " << total << " 个节点，用时 " << seconds << " 秒，每秒 " << total / seconds << " 个节点" << endl;
+	return 0;
+}
@@ -0,0 +1,65 @@
+// 对局记录统计：扫描 RecordWriter 写出的记录文件，输出局数、胜负分布、平均回合数和扫描速度
+// 编译：g++ -O2 -std=c++11 -o records tools/records.cpp
+// 用法：records [-r] 记录文件
+// -r：在 TankField 上回放每一局，检查动作都合法，且已结束的对局结果与记录一致
+
+#define TANKGAME_NO_MAIN
+#include "../main.cpp"
+
+#include <chrono>
+
+int main(int argc, char **argv)
+{
+	bool replay = false;
+	const char *path = nullptr;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-r"))
+			replay = true;
+		else
+			path = argv[i];
+	}
+	if (!path)
+	{
+		std::cerr << "用法：records [-r] 记录文件" << endl;
+		return 1;
+	}
+	TankGame::RecordReader reader(path);
+	if (!reader.IsOpen())
+	{
+		std::cerr << "无法读取记录文件：" << path << endl;
+		return 1;
+	}
+
+	// results[GameResult + 2]：未结束、平局、蓝胜、红胜
+	long long games = 0, turns = 0, results[4] = {}, mismatches = 0;
+	auto start = std::chrono::steady_clock::now();
+	TankGame::RecordView record;
+	while (reader.Next(record))
+	{
+		games++;
+		turns += record.Turns();
+		results[record.Result() + 2]++;
+		if (replay)
+		{
+			int hasBrick[3];
+			record.GetField(hasBrick);
+			TankGame::TankField field(hasBrick, TankGame::Blue);
+			bool valid = record.Replay(field, record.Turns());
+			TankGame::GameResult result = field.GetGameResult();
+			// 因非法动作结束的对局，回放到最后一回合时仍然是未结束
+			if (!valid || (result != TankGame::NotFinished && result != record.Result()))
+				mismatches++;
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	cout << games << " 局，平均 " << (games ? (double)turns / games : 0) << " 回合" << endl;
+	cout << "蓝胜 " << results[TankGame::Blue + 2] << "，红胜 " << results[TankGame::Red + 2]
+		 << "，平局 " << results[TankGame::Draw + 2] << "，未结束 " << results[TankGame::NotFinished + 2] << endl;
+	if (replay)
+		cout << "回放与记录不一致：" << mismatches << " 局" << endl;
+	cout << "用时 " << seconds << " 秒，每秒 " << games / seconds << " 局，"
+		 << reader.Size() / seconds / (1 << 20) << " MB/s" << endl;
+	return mismatches ? 2 : 0;
+}
@@ -0,0 +1,145 @@
+// 决策回归测试：把对局记录还原成 bot 实际收到的输入，逐回合经过 ReadInput 和决策代码，
+// 与记录中的动作比较，并统计每回合（读入和决策）的耗时
+// 编译：g++ -O2 -std=c++11 -o replay tools/replay.cpp
+// 用法：replay [-side 0|1] [-show 最多显示的差异数] 记录文件
+// 只检查 -side 指定的一方（默认双方都检查），这一方在记录中应该是由当前的 heuristic 下的
+// 无论决策是否一致，都按记录中的动作继续，因此一处差异不会影响之后的回合
+// 有差异时返回 2，便于在脚本中使用
+
+#define TANKGAME_NO_MAIN
+#include "../main.cpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+
+namespace Replay
+{
+using TankGame::Action;
+using TankGame::sideCount;
+using TankGame::tankPerSide;
+
+struct Mismatch
+{
+	long long game;
+	int turn, side;
+	Action expected[tankPerSide], actual[tankPerSide];
+};
+
+// 由场地和执哪一方决定随机种子，同一条记录每次回放都相同
+unsigned int SeedOf(const int hasBrick[3], int side)
+{
+	unsigned int seed = 2166136261U;
+	for (int i = 0; i < 3; i++)
+		seed = (seed ^ (unsigned int)hasBrick[i]) * 16777619U;
+	return (seed ^ (unsigned int)side) * 16777619U;
+}
+
+// 以 side 方的身份回放一局，返回有差异的回合数
+int ReplayGame(const TankGame::RecordView &record, long long game, int side,
+			   std::vector<double> &latency, std::vector<Mismatch> &mismatches, size_t maxMismatches)
+{
+	int hasBrick[3], differences = 0;
+	record.GetField(hasBrick);
+	TankGame::threadRandom.Seed(SeedOf(hasBrick, side));
+	TankGame::GameContext context;
+	std::unique_ptr<BotContext> bot(new BotContext);
+	HeuristicPolicy policy;
+
+	for (int turn = 1; turn <= record.Turns(); turn++)
+	{
+		// 第一回合是裁判介绍场地，之后是长时运行模式下对方上回合的动作
+		std::ostringstream line;
+		if (turn == 1)
+			line << "{\"requests\":[{\"field\":[" << hasBrick[0] << ',' << hasBrick[1] << ',' << hasBrick[2]
+				 << "],\"mySide\":" << side << "}],\"responses\":[]}";
+		else
+			line << '[' << record.GetAction(turn - 1, 1 - side, 0) << ',' << record.GetAction(turn - 1, 1 - side, 1) << ']';
+		std::istringstream in(line.str());
+
+		auto start = std::chrono::steady_clock::now();
+		string data, globalData;
+		TankGame::ReadInput(context, in, data, globalData);
+		Action actual[tankPerSide];
+		decide_turn(context, *bot, policy, context.field->mySide, actual[0], actual[1]);
+		latency.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+
+		Action expected[tankPerSide] = {record.GetAction(turn, side, 0), record.GetAction(turn, side, 1)};
+		if (expected[0] != actual[0] || expected[1] != actual[1])
+		{
+			differences++;
+			if (mismatches.size() < maxMismatches)
+				mismatches.push_back(Mismatch{game, turn, side, {expected[0], expected[1]}, {actual[0], actual[1]}});
+		}
+
+		// 与 SubmitAndDontExit 相同，但提交的是记录中的动作
+		for (int tank = 0; tank < tankPerSide; tank++)
+			context.field->nextAction[side][tank] = expected[tank];
+	}
+	return differences;
+}
+
+double Percentile(std::vector<double> &values, double p)
+{
+	if (values.empty())
+		return 0;
+	size_t index = std::min(values.size() - 1, (size_t)(p * values.size()));
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+	return values[index];
+}
+} // namespace Replay
+
+int main(int argc, char **argv)
+{
+	int onlySide = -1;
+	size_t maxMismatches = 20;
+	const char *path = nullptr;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-side") && i + 1 < argc)
+			onlySide = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-show") && i + 1 < argc)
+			maxMismatches = (size_t)atoi(argv[++i]);
+		else
+			path = argv[i];
+	}
+	if (!path)
+	{
+		std::cerr << "用法：replay [-side 0|1] [-show 最多显示的差异数] 记录文件" << endl;
+		return 1;
+	}
+	TankGame::RecordReader reader(path);
+	if (!reader.IsOpen())
+	{
+		std::cerr << "无法读取记录文件：" << path << endl;
+		return 1;
+	}
+
+	long long games = 0, turns = 0, differences = 0;
+	std::vector<double> latency;
+	std::vector<Replay::Mismatch> mismatches;
+	TankGame::RecordView record;
+	while (reader.Next(record))
+	{
+		for (int side = 0; side < TankGame::sideCount; side++)
+			if (onlySide < 0 || side == onlySide)
+			{
+				differences += Replay::ReplayGame(record, games, side, latency, mismatches, maxMismatches);
+				turns += record.Turns();
+			}
+		games++;
+	}
+
+	for (auto &mismatch : mismatches)
+		cout << "第 " << mismatch.game << " 局第 " << mismatch.turn << " 回合 " << (mismatch.side ? "红" : "蓝")
+			 << "方：记录为 [" << mismatch.expected[0] << "," << mismatch.expected[1] << "]，决策为 ["
+			 << mismatch.actual[0] << "," << mismatch.actual[1] << "]" << endl;
+	cout << games << " 局，" << turns << " 个回合，其中 " << differences << " 个回合的决策与记录不同" << endl;
+	cout << "每回合耗时（微秒）：p50 " << Replay::Percentile(latency, 0.5)
+		 << "  p90 " << Replay::Percentile(latency, 0.9)
+		 << "  p99 " << Replay::Percentile(latency, 0.99)
+		 << "  max " << Replay::Percentile(latency, 1) << endl;
+	return differences ? 2 : 0;
+}